@@ -0,0 +1,424 @@
+/**
+ * @file AggregatingConsumer.h
+ *
+ * @brief AggregatingConsumer class for per-key aggregation over time windows without shared writes.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef AGGREGATING_CONSUMER_H
+#define AGGREGATING_CONSUMER_H
+
+#include "ProducerConsumerBase.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mt
+{
+    // Open-addressing hash map with linear probing over one contiguous slot array. clear() keeps
+    // the capacity, so a partial reused window after window stops allocating once it has grown.
+    template<typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class FlatHashMap
+    {
+    private:
+        struct Slot
+        {
+            Key key{};
+            Value value{};
+            bool occupied = false;
+        };
+
+        std::vector<Slot> m_slots;
+        std::size_t m_size = 0;
+        [[no_unique_address]] Hash m_hash;
+        [[no_unique_address]] KeyEqual m_keyEqual;
+
+    public:
+        explicit FlatHashMap(std::size_t capacity = 16);
+        FlatHashMap(const FlatHashMap&) = default;
+        FlatHashMap(FlatHashMap&&) = default;
+        FlatHashMap& operator=(const FlatHashMap&) = default;
+        FlatHashMap& operator=(FlatHashMap&&) = default;
+        ~FlatHashMap() = default;
+
+        // Returns the value for key, default constructed and flagged as inserted if it was absent.
+        std::pair<Value&, bool> findOrInsert(const Key& key);
+        [[nodiscard]] const Value* find(const Key& key) const;
+
+        template<typename Fn>
+        void forEach(Fn&& fn) const;
+
+        [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+        [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+        void clear();
+
+    private:
+        [[nodiscard]] std::size_t slotOf(const Key& key) const;
+        void grow();
+    };
+
+    // Collects the partials of every attached AggregatingConsumer. A window closes once each
+    // attached worker has moved past it; its partials are merged then, and the result is handed
+    // to onWindow on the worker thread that closed it. Windows nobody contributed to are skipped.
+    template<typename Key, typename Value, typename Reduce = std::plus<>, typename Hash = std::hash<Key>>
+    class WindowAggregator
+    {
+    public:
+        using Map = FlatHashMap<Key, Value, Hash>;
+        using Clock = std::chrono::steady_clock;
+        using Callback = std::function<void(Clock::time_point start, Clock::time_point end, const Map& aggregate)>;
+
+        class Attachment
+        {
+        private:
+            WindowAggregator* m_aggregator;
+            std::size_t m_worker;
+
+        public:
+            Attachment(WindowAggregator& aggregator, std::size_t worker) noexcept;
+            Attachment(const Attachment&) = delete;
+            Attachment(Attachment&&) = delete;
+            Attachment& operator=(const Attachment&) = delete;
+            Attachment& operator=(Attachment&&) = delete;
+            ~Attachment();
+
+            // Hands over the partial of window and everything before it, leaving partial empty.
+            void publish(std::uint64_t window, Map& partial);
+        };
+
+    private:
+        Clock::duration m_window;
+        Clock::time_point m_epoch;
+        Callback m_onWindow;
+        Reduce m_reduce;
+        std::mutex m_mutex;
+        std::size_t m_nextWorker = 0;
+        std::unordered_map<std::size_t, std::uint64_t> m_nextUnpublished;
+        std::map<std::uint64_t, Map> m_pending;
+
+    public:
+        explicit WindowAggregator(Clock::duration window, Callback onWindow, Reduce reduce = Reduce{});
+        WindowAggregator(const WindowAggregator&) = delete;
+        WindowAggregator(WindowAggregator&&) = delete;
+        WindowAggregator& operator=(const WindowAggregator&) = delete;
+        WindowAggregator& operator=(WindowAggregator&&) = delete;
+        ~WindowAggregator() = default;
+
+        [[nodiscard]] std::uint64_t windowIndex(Clock::time_point time) const;
+        [[nodiscard]] const Reduce& reduce() const noexcept { return m_reduce; }
+        [[nodiscard]] std::size_t attach();
+        void publish(std::size_t worker, std::uint64_t window, Map& partial);
+        void detach(std::size_t worker);
+
+    private:
+        void mergeLocked(Map& into, const Map& partial);
+        void closeWindowsLocked();
+    };
+
+    // Consumer that folds valueOf(item) into a private partial under keyOf(item) and publishes the
+    // partial to the shared WindowAggregator only when its window ends. Several instances may
+    // drain the same adapter into the same aggregator.
+    template<typename Adapter, typename Aggregator, typename KeyOf, typename ValueOf>
+    class AggregatingConsumer : public ProducerConsumerBase<Adapter>
+    {
+    private:
+        using Super = ProducerConsumerBase<Adapter>;
+        using Elem = typename Adapter::Elem;
+        using Map = typename Aggregator::Map;
+        using Clock = typename Aggregator::Clock;
+
+        Aggregator& m_aggregator;
+        KeyOf m_keyOf;
+        ValueOf m_valueOf;
+        std::remove_cvref_t<decltype(std::declval<Aggregator&>().reduce())> m_reduce;
+        Map m_partial;
+
+    public:
+        explicit AggregatingConsumer(Adapter& sharedContainer, Aggregator& aggregator, KeyOf keyOf, ValueOf valueOf);
+        AggregatingConsumer(const AggregatingConsumer&) = delete;
+        AggregatingConsumer(AggregatingConsumer&&) = delete;
+        AggregatingConsumer& operator=(const AggregatingConsumer&) = delete;
+        AggregatingConsumer& operator=(AggregatingConsumer&&) = delete;
+        ~AggregatingConsumer() override;
+
+    private:
+        void workerThreadWork() override;
+        void accumulate(const Elem& item);
+    };
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    FlatHashMap<Key, Value, Hash, KeyEqual>::FlatHashMap(const std::size_t capacity)
+        : m_slots(std::bit_ceil(std::max<std::size_t>(capacity, 2)))
+    { }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    std::size_t FlatHashMap<Key, Value, Hash, KeyEqual>::slotOf(const Key& key) const
+    {
+        // std::hash is the identity for integers, so mix the bits before masking.
+        std::uint64_t hash = static_cast<std::uint64_t>(m_hash(key));
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+        return static_cast<std::size_t>(hash) & (m_slots.size() - 1);
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    std::pair<Value&, bool> FlatHashMap<Key, Value, Hash, KeyEqual>::findOrInsert(const Key& key)
+    {
+        if (2 * (m_size + 1) > m_slots.size())
+        {
+            grow();
+        }
+        const std::size_t mask = m_slots.size() - 1;
+        for (std::size_t i = slotOf(key);; i = (i + 1) & mask)
+        {
+            Slot& slot = m_slots[i];
+            if (!slot.occupied)
+            {
+                slot.key = key;
+                slot.occupied = true;
+                ++m_size;
+                return { slot.value, true };
+            }
+            if (m_keyEqual(slot.key, key))
+            {
+                return { slot.value, false };
+            }
+        }
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    const Value* FlatHashMap<Key, Value, Hash, KeyEqual>::find(const Key& key) const
+    {
+        const std::size_t mask = m_slots.size() - 1;
+        for (std::size_t i = slotOf(key);; i = (i + 1) & mask)
+        {
+            const Slot& slot = m_slots[i];
+            if (!slot.occupied)
+            {
+                return nullptr;
+            }
+            if (m_keyEqual(slot.key, key))
+            {
+                return &slot.value;
+            }
+        }
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    template<typename Fn>
+    void FlatHashMap<Key, Value, Hash, KeyEqual>::forEach(Fn&& fn) const
+    {
+        for (const Slot& slot : m_slots)
+        {
+            if (slot.occupied)
+            {
+                fn(slot.key, slot.value);
+            }
+        }
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    void FlatHashMap<Key, Value, Hash, KeyEqual>::clear()
+    {
+        if (m_size == 0)
+        {
+            return;
+        }
+        std::fill(m_slots.begin(), m_slots.end(), Slot{});
+        m_size = 0;
+    }
+
+    template<typename Key, typename Value, typename Hash, typename KeyEqual>
+    void FlatHashMap<Key, Value, Hash, KeyEqual>::grow()
+    {
+        std::vector<Slot> old(m_slots.size() * 2);
+        old.swap(m_slots);
+        const std::size_t mask = m_slots.size() - 1;
+        for (Slot& slot : old)
+        {
+            if (!slot.occupied)
+            {
+                continue;
+            }
+            std::size_t i = slotOf(slot.key);
+            while (m_slots[i].occupied)
+            {
+                i = (i + 1) & mask;
+            }
+            m_slots[i] = std::move(slot);
+        }
+    }
+
+    template<typename Key, typename Value, typename Reduce, typename Hash>
+    WindowAggregator<Key, Value, Reduce, Hash>::Attachment::Attachment(WindowAggregator& aggregator, const std::size_t worker) noexcept
+        : m_aggregator(&aggregator)
+        , m_worker(worker)
+    { }
+
+    template<typename Key, typename Value, typename Reduce, typename Hash>
+    WindowAggregator<Key, Value, Reduce, Hash>::Attachment::~Attachment()
+    {
+        try
+        {
+            m_aggregator->detach(m_worker);
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << "AGGREGATOR -> " << ex.what() << std::endl;
+        }
+        catch (...)
+        {
+            std::cerr << "AGGREGATOR -> Unknown exception" << std::endl;
+        }
+    }
+
+    template<typename Key, typename Value, typename Reduce, typename Hash>
+    void WindowAggregator<Key, Value, Reduce, Hash>::Attachment::publish(const std::uint64_t window, Map& partial)
+    {
+        m_aggregator->publish(m_worker, window, partial);
+    }
+
+    template<typename Key, typename Value, typename Reduce, typename Hash>
+    WindowAggregator<Key, Value, Reduce, Hash>::WindowAggregator(const Clock::duration window, Callback onWindow, Reduce reduce)
+        : m_window(std::max(window, Clock::duration{ 1 }))
+        , m_epoch(Clock::now())
+        , m_onWindow(std::move(onWindow))
+        , m_reduce(std::move(reduce))
+    { }
+
+    template<typename Key, typename Value, typename Reduce, typename Hash>
+    std::uint64_t WindowAggregator<Key, Value, Reduce, Hash>::windowIndex(const Clock::time_point time) const
+    {
+        return time <= m_epoch ? 0 : static_cast<std::uint64_t>((time - m_epoch) / m_window);
+    }
+
+    // A new worker has contributed nothing to the windows before the current one, but holds the
+    // current one back until it has published it.
+    template<typename Key, typename Value, typename Reduce, typename Hash>
+    std::size_t WindowAggregator<Key, Value, Reduce, Hash>::attach()
+    {
+        const std::uint64_t current = windowIndex(Clock::now());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const std::size_t worker = m_nextWorker++;
+        m_nextUnpublished.emplace(worker, current);
+        return worker;
+    }
+
+    template<typename Key, typename Value, typename Reduce, typename Hash>
+    void WindowAggregator<Key, Value, Reduce, Hash>::publish(const std::size_t worker, const std::uint64_t window, Map& partial)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!partial.empty())
+        {
+            mergeLocked(m_pending[window], partial);
+            partial.clear();
+        }
+        std::uint64_t& nextUnpublished = m_nextUnpublished[worker];
+        nextUnpublished = std::max(nextUnpublished, window + 1);
+        closeWindowsLocked();
+    }
+
+    template<typename Key, typename Value, typename Reduce, typename Hash>
+    void WindowAggregator<Key, Value, Reduce, Hash>::detach(const std::size_t worker)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_nextUnpublished.erase(worker);
+        closeWindowsLocked();
+    }
+
+    template<typename Key, typename Value, typename Reduce, typename Hash>
+    void WindowAggregator<Key, Value, Reduce, Hash>::mergeLocked(Map& into, const Map& partial)
+    {
+        partial.forEach([&](const Key& key, const Value& value)
+            {
+                auto [aggregate, inserted] = into.findOrInsert(key);
+                aggregate = inserted ? value : m_reduce(aggregate, value);
+            });
+    }
+
+    template<typename Key, typename Value, typename Reduce, typename Hash>
+    void WindowAggregator<Key, Value, Reduce, Hash>::closeWindowsLocked()
+    {
+        std::uint64_t openFrom = std::numeric_limits<std::uint64_t>::max();
+        for (const auto& [worker, nextUnpublished] : m_nextUnpublished)
+        {
+            openFrom = std::min(openFrom, nextUnpublished);
+        }
+        while (!m_pending.empty() && m_pending.begin()->first < openFrom)
+        {
+            const auto node = m_pending.extract(m_pending.begin());
+            const Clock::time_point start = m_epoch + m_window * static_cast<Clock::rep>(node.key());
+            m_onWindow(start, start + m_window, node.mapped());
+        }
+    }
+
+    template<typename Adapter, typename Aggregator, typename KeyOf, typename ValueOf>
+    AggregatingConsumer<Adapter, Aggregator, KeyOf, ValueOf>::AggregatingConsumer(Adapter& sharedContainer, Aggregator& aggregator,
+        KeyOf keyOf, ValueOf valueOf)
+        : Super(Super::Type::Consumer, sharedContainer)
+        , m_aggregator(aggregator)
+        , m_keyOf(std::move(keyOf))
+        , m_valueOf(std::move(valueOf))
+        , m_reduce(aggregator.reduce())
+    {
+        this->runMainThread();
+    }
+
+    template<typename Adapter, typename Aggregator, typename KeyOf, typename ValueOf>
+    AggregatingConsumer<Adapter, Aggregator, KeyOf, ValueOf>::~AggregatingConsumer()
+    {
+        this->shutdownMainThread();
+    }
+
+    template<typename Adapter, typename Aggregator, typename KeyOf, typename ValueOf>
+    void AggregatingConsumer<Adapter, Aggregator, KeyOf, ValueOf>::workerThreadWork()
+    {
+        typename Aggregator::Attachment attachment(m_aggregator, m_aggregator.attach());
+        std::uint64_t window = m_aggregator.windowIndex(Clock::now());
+        while (this->m_workerThreadEnabled)
+        {
+            Elem item;
+            const bool popped = this->m_sharedContainer.tryPop(item);
+            if (const std::uint64_t current = m_aggregator.windowIndex(Clock::now()); current != window)
+            {
+                attachment.publish(window, m_partial);
+                window = current;
+            }
+            if (popped)
+            {
+                accumulate(item);
+                this->onWork();
+            }
+            else
+            {
+                this->onIdle();
+            }
+        }
+        attachment.publish(window, m_partial);
+    }
+
+    template<typename Adapter, typename Aggregator, typename KeyOf, typename ValueOf>
+    void AggregatingConsumer<Adapter, Aggregator, KeyOf, ValueOf>::accumulate(const Elem& item)
+    {
+        auto [aggregate, inserted] = m_partial.findOrInsert(m_keyOf(item));
+        aggregate = inserted ? m_valueOf(item) : m_reduce(aggregate, m_valueOf(item));
+    }
+} // namespace mt
+
+#endif
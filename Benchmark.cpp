@@ -0,0 +1,582 @@
+/**
+ * @file Benchmark.cpp
+ *
+ * @brief Benchmarks for Producer, Consumer and ThreadSafeSTLAdapter.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#include "Consumer.h"
+#include "Producer.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <sstream>
+#include <stack>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    [[nodiscard]] std::int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    [[nodiscard]] std::string jsonEscape(const std::string_view text)
+    {
+        std::string escaped;
+        for (const char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                escaped += '\\';
+            }
+            if (static_cast<unsigned char>(c) >= 0x20)
+            {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    // Every repetition of a benchmark adds one sample to its result, so that BenchmarkCompare
+    // can judge differences between runs against the spread within a run.
+    class Results
+    {
+    private:
+        struct Result
+        {
+            std::string name;
+            std::string unit;
+            bool higherIsBetter;
+            std::vector<double> samples;
+        };
+
+        std::vector<Result> m_results;
+
+    public:
+        void add(const std::string& name, const std::string_view unit, const bool higherIsBetter, const double sample)
+        {
+            const auto it = std::find_if(m_results.begin(), m_results.end(), [&](const Result& result) { return result.name == name; });
+            if (it == m_results.end())
+            {
+                m_results.push_back(Result{ name, std::string(unit), higherIsBetter, { sample } });
+            }
+            else
+            {
+                it->samples.push_back(sample);
+            }
+        }
+
+        void writeJson(const std::string& path, const std::size_t repetitions) const
+        {
+            utsname system{};
+            ::uname(&system);
+            char hostname[256] = {};
+            ::gethostname(hostname, sizeof(hostname) - 1);
+            std::string cpuModel;
+            std::ifstream cpuInfo("/proc/cpuinfo");
+            for (std::string line; std::getline(cpuInfo, line);)
+            {
+                if (line.rfind("model name", 0) == 0)
+                {
+                    cpuModel = line.substr(line.find(':') + 2);
+                    break;
+                }
+            }
+#ifdef NDEBUG
+            constexpr bool optimized = true;
+#else
+            constexpr bool optimized = false;
+#endif
+
+            std::ofstream out(path, std::ios::trunc);
+            out << "{\n  \"environment\": {\n"
+                << "    \"timestamp\": " << std::time(nullptr) << ",\n"
+                << "    \"hostname\": \"" << jsonEscape(hostname) << "\",\n"
+                << "    \"kernel\": \"" << jsonEscape(system.sysname) << ' ' << jsonEscape(system.release) << "\",\n"
+                << "    \"machine\": \"" << jsonEscape(system.machine) << "\",\n"
+                << "    \"cpu_model\": \"" << jsonEscape(cpuModel) << "\",\n"
+                << "    \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n"
+                << "    \"compiler\": \"" << jsonEscape(__VERSION__) << "\",\n"
+                << "    \"ndebug\": " << (optimized ? "true" : "false") << ",\n"
+                << "    \"repetitions\": " << repetitions << "\n  },\n  \"results\": [";
+            for (std::size_t i = 0; i < m_results.size(); ++i)
+            {
+                const Result& result = m_results[i];
+                out << (i == 0 ? "\n" : ",\n") << "    { \"name\": \"" << jsonEscape(result.name) << "\", \"unit\": \"" << result.unit
+                    << "\", \"higher_is_better\": " << (result.higherIsBetter ? "true" : "false") << ", \"samples\": [";
+                for (std::size_t j = 0; j < result.samples.size(); ++j)
+                {
+                    out << (j == 0 ? "" : ", ") << std::setprecision(10) << result.samples[j];
+                }
+                out << "] }";
+            }
+            out << "\n  ]\n}\n";
+            if (!out.flush())
+            {
+                std::cerr << "Failed to write " << path << std::endl;
+            }
+        }
+    };
+
+    class Histogram
+    {
+    private:
+        std::array<std::uint64_t, 64> m_buckets{};
+        std::vector<std::int64_t> m_samples;
+
+    public:
+        void add(const std::int64_t ns)
+        {
+            const auto value = static_cast<std::uint64_t>(std::max<std::int64_t>(ns, 0));
+            ++m_buckets[static_cast<std::size_t>(std::bit_width(value))];
+            m_samples.push_back(ns);
+        }
+
+        void print(std::ostream& out)
+        {
+            if (m_samples.empty())
+            {
+                out << "  no samples" << std::endl;
+                return;
+            }
+            std::sort(m_samples.begin(), m_samples.end());
+            const auto percentile = [&](const double p)
+                {
+                    return m_samples[static_cast<std::size_t>(p * static_cast<double>(m_samples.size() - 1))];
+                };
+            out << "  samples=" << m_samples.size() << " p50=" << percentile(0.5) << "ns p99=" << percentile(0.99)
+                << "ns p99.9=" << percentile(0.999) << "ns max=" << m_samples.back() << "ns" << std::endl;
+            const auto peak = *std::max_element(m_buckets.cbegin(), m_buckets.cend());
+            for (std::size_t i = 0; i < m_buckets.size(); ++i)
+            {
+                if (m_buckets[i] == 0)
+                {
+                    continue;
+                }
+                const std::uint64_t upper = i == 0 ? 0 : (std::uint64_t{ 1 } << i) - 1;
+                out << "  <=" << std::setw(10) << upper << "ns " << std::setw(9) << m_buckets[i] << ' '
+                    << std::string(static_cast<std::size_t>(50 * m_buckets[i] / peak), '#') << std::endl;
+            }
+        }
+    };
+
+    // Counts hardware and software events of the whole process, including threads started after
+    // the counters were opened. Counters the kernel refuses (e.g. perf_event_paranoid, no PMU in a
+    // VM) are reported as n/a.
+    class PerfCounters
+    {
+    private:
+        struct Counter
+        {
+            const char* name;
+            std::uint32_t type;
+            std::uint64_t config;
+            int fd = -1;
+            std::uint64_t value = 0;
+        };
+
+        std::array<Counter, 4> m_counters{ {
+            { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { "cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+            { "context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES } } };
+
+    public:
+        PerfCounters()
+        {
+            for (Counter& counter : m_counters)
+            {
+                perf_event_attr attr{};
+                attr.size = sizeof(attr);
+                attr.type = counter.type;
+                attr.config = counter.config;
+                attr.disabled = 1;
+                attr.inherit = 1;
+                attr.exclude_kernel = counter.type == PERF_TYPE_HARDWARE;
+                attr.exclude_hv = 1;
+                counter.fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            }
+        }
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters(PerfCounters&&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+        PerfCounters& operator=(PerfCounters&&) = delete;
+        ~PerfCounters()
+        {
+            for (const Counter& counter : m_counters)
+            {
+                if (counter.fd >= 0)
+                {
+                    ::close(counter.fd);
+                }
+            }
+        }
+
+        void start()
+        {
+            for (const Counter& counter : m_counters)
+            {
+                if (counter.fd >= 0)
+                {
+                    ::ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+                    ::ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+        }
+
+        void stop()
+        {
+            for (Counter& counter : m_counters)
+            {
+                if (counter.fd >= 0)
+                {
+                    ::ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+                    if (::read(counter.fd, &counter.value, sizeof(counter.value)) != sizeof(counter.value))
+                    {
+                        counter.value = 0;
+                    }
+                }
+            }
+        }
+
+        void printPerOperation(std::ostream& out, const std::size_t operations) const
+        {
+            for (const Counter& counter : m_counters)
+            {
+                out << ' ' << counter.name << "/op=";
+                if (counter.fd < 0)
+                {
+                    out << "n/a";
+                }
+                else
+                {
+                    out << std::defaultfloat << std::setprecision(4) << static_cast<double>(counter.value) / static_cast<double>(operations);
+                }
+            }
+        }
+    };
+
+    // Moves count items from the producers through sharedContainer to the consumers and reports
+    // ops/sec with per-item hardware counters for the given adapter and topology.
+    template<typename Adapter>
+    double throughputBenchmark(const std::string_view adapterName, Adapter& sharedContainer, const std::size_t producerCount,
+        const std::size_t consumerCount, const std::size_t count)
+    {
+        constexpr std::size_t BatchSize = 64;
+        using Elem = typename Adapter::Elem;
+        std::atomic<std::size_t> received{ 0 };
+        const auto callable = [&received](const Elem&) { received.fetch_add(1, std::memory_order_relaxed); };
+
+        PerfCounters counters;
+        std::vector<std::unique_ptr<mt::Producer<Adapter>>> producers;
+        std::vector<std::unique_ptr<mt::Consumer<Adapter, decltype(callable)>>> consumers;
+        for (std::size_t i = 0; i < producerCount; ++i)
+        {
+            producers.push_back(std::make_unique<mt::Producer<Adapter>>(sharedContainer));
+        }
+        for (std::size_t i = 0; i < consumerCount; ++i)
+        {
+            consumers.push_back(std::make_unique<mt::Consumer<Adapter, decltype(callable)>>(sharedContainer, callable));
+        }
+
+        counters.start();
+        const auto start = Clock::now();
+        for (auto& producer : producers)
+        {
+            producer->enableWorkerThread();
+        }
+        for (auto& consumer : consumers)
+        {
+            consumer->enableWorkerThread();
+        }
+        for (std::size_t pushed = 0; pushed < count;)
+        {
+            for (auto& producer : producers)
+            {
+                const std::size_t batch = std::min(BatchSize, count - pushed);
+                producer->push(std::vector<Elem>(batch, static_cast<Elem>(pushed)));
+                pushed += batch;
+                if (pushed == count)
+                {
+                    break;
+                }
+            }
+        }
+        while (received.load(std::memory_order_relaxed) < count)
+        {
+            std::this_thread::yield();
+        }
+        const auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        // Counts of inherited counters reach the parent only when a thread exits, so join all workers first.
+        producers.clear();
+        consumers.clear();
+        counters.stop();
+
+        const double opsPerSecond = static_cast<double>(count) / elapsed;
+        std::cout << "throughput adapter=" << adapterName << " topology=" << producerCount << "p" << consumerCount << "c"
+            << " ops/sec=" << std::fixed << std::setprecision(0) << opsPerSecond;
+        counters.printPerOperation(std::cout, count);
+        std::cout << std::endl;
+        return opsPerSecond;
+    }
+
+    void throughputBenchmarks(Results& results, const std::size_t count)
+    {
+        constexpr std::pair<std::size_t, std::size_t> Topologies[] = { { 1, 1 }, { 4, 1 }, { 1, 4 }, { 4, 4 } };
+        for (const auto& [producerCount, consumerCount] : Topologies)
+        {
+            const std::string topology = "/" + std::to_string(producerCount) + "p" + std::to_string(consumerCount) + "c";
+            auto queue = mt::createThreadSafeSTLAdapterFrom(std::queue<std::int64_t>{});
+            results.add("end_to_end/queue" + topology, "ops/s", true, throughputBenchmark("queue", queue, producerCount, consumerCount, count));
+            auto stack = mt::createThreadSafeSTLAdapterFrom(std::stack<std::int64_t>{});
+            results.add("end_to_end/stack" + topology, "ops/s", true, throughputBenchmark("stack", stack, producerCount, consumerCount, count));
+            auto priorityQueue = mt::createThreadSafeSTLAdapterFrom(std::priority_queue<std::int64_t, std::vector<std::int64_t>, std::less<>>{},
+                std::less<>{});
+            results.add("end_to_end/priority_queue" + topology, "ops/s", true,
+                throughputBenchmark("priority_queue", priorityQueue, producerCount, consumerCount, count));
+        }
+    }
+
+    // Single-threaded push of count elements followed by popping them all, in ns per push/pop pair.
+    template<typename Adapter>
+    double pushPopBenchmark(const std::string_view adapterName, Adapter& sharedContainer, const std::size_t count)
+    {
+        typename Adapter::Elem item{};
+        const auto start = Clock::now();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            sharedContainer.push(static_cast<std::int64_t>(i));
+        }
+        while (sharedContainer.tryPop(item))
+        {
+        }
+        const double nsPerOperation = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(count);
+        std::cout << "push_pop adapter=" << adapterName << " ns/op=" << std::fixed << std::setprecision(1) << nsPerOperation << std::endl;
+        return nsPerOperation;
+    }
+
+    void pushPopBenchmarks(Results& results, const std::size_t count)
+    {
+        auto queue = mt::createThreadSafeSTLAdapterFrom(std::queue<std::int64_t>{});
+        results.add("push_pop/queue", "ns/op", false, pushPopBenchmark("queue", queue, count));
+        auto stack = mt::createThreadSafeSTLAdapterFrom(std::stack<std::int64_t>{});
+        results.add("push_pop/stack", "ns/op", false, pushPopBenchmark("stack", stack, count));
+        auto priorityQueue = mt::createThreadSafeSTLAdapterFrom(std::priority_queue<std::int64_t, std::vector<std::int64_t>, std::less<>>{},
+            std::less<>{});
+        results.add("push_pop/priority_queue", "ns/op", false, pushPopBenchmark("priority_queue", priorityQueue, count));
+    }
+
+    // Enable latency is the time from enableWorkerThread until the worker loop first beats. Disable
+    // latency is the time from disableWorkerThread until the worker is marked disabled and has
+    // beaten for the last time, which is taken to be once it stays quiet for QuietPeriod. Each
+    // enable starts only after that, so no beat of the previous worker is mistaken for the new one.
+    void toggleBenchmark(Results& results, const std::size_t count)
+    {
+        constexpr auto QuietPeriod = std::chrono::milliseconds(1);
+        auto sharedContainer = mt::createThreadSafeSTLAdapterFrom(std::queue<std::int64_t>{});
+        mt::Consumer consumer(sharedContainer, [](const std::int64_t) { });
+        double enableNs = 0.0;
+        double disableNs = 0.0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const std::uint64_t heartbeats = consumer.heartbeats();
+            const auto enableStart = Clock::now();
+            consumer.enableWorkerThread();
+            while (consumer.heartbeats() == heartbeats)
+            {
+                std::this_thread::yield();
+            }
+            enableNs += std::chrono::duration<double, std::nano>(Clock::now() - enableStart).count();
+
+            const auto disableStart = Clock::now();
+            consumer.disableWorkerThread();
+            std::uint64_t seen = consumer.heartbeats();
+            auto lastBeat = disableStart;
+            std::optional<Clock::time_point> disabledAt;
+            while (!disabledAt || Clock::now() - std::max(lastBeat, *disabledAt) < QuietPeriod)
+            {
+                if (const std::uint64_t beats = consumer.heartbeats(); beats != seen)
+                {
+                    seen = beats;
+                    lastBeat = Clock::now();
+                }
+                if (!disabledAt && !consumer.workerThreadEnabled())
+                {
+                    disabledAt = Clock::now();
+                }
+                std::this_thread::yield();
+            }
+            disableNs += std::chrono::duration<double, std::nano>(std::max(lastBeat, *disabledAt) - disableStart).count();
+        }
+        const double averageEnableNs = enableNs / static_cast<double>(count);
+        const double averageDisableNs = disableNs / static_cast<double>(count);
+        std::cout << "toggle enable-latency=" << std::fixed << std::setprecision(0) << averageEnableNs << "ns"
+            << " disable-latency=" << averageDisableNs << "ns" << std::endl;
+        results.add("toggle/enable_latency", "ns", false, averageEnableNs);
+        results.add("toggle/disable_latency", "ns", false, averageDisableNs);
+    }
+
+    // Sends one timestamp every intervalNs through Producer -> adapter -> Consumer and
+    // reports the histograms of the consumer-side inter-arrival times and end-to-end latency.
+    void jitterBenchmark(const mt::RealTimeOptions& options, const std::int64_t intervalNs, const std::size_t count)
+    {
+        Histogram interArrival;
+        Histogram latency;
+        std::int64_t previousArrival = 0;
+        std::atomic<std::size_t> received{ 0 };
+        auto sharedContainer = mt::createThreadSafeSTLAdapterFrom(std::queue<std::int64_t>{});
+        mt::Producer producer(sharedContainer);
+        mt::Consumer consumer(sharedContainer, [&](const std::int64_t sent)
+            {
+                const std::int64_t arrival = nowNs();
+                latency.add(arrival - sent);
+                if (previousArrival != 0)
+                {
+                    interArrival.add(arrival - previousArrival);
+                }
+                previousArrival = arrival;
+                received.fetch_add(1, std::memory_order_release);
+            });
+        producer.setRealTimeOptions(options);
+        mt::RealTimeOptions consumerOptions = options;
+        if (consumerOptions.cpu >= 0)
+        {
+            ++consumerOptions.cpu;
+        }
+        consumer.setRealTimeOptions(consumerOptions);
+        producer.enableWorkerThread();
+        consumer.enableWorkerThread();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        std::int64_t next = nowNs();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            next += intervalNs;
+            while (nowNs() < next)
+            {
+                mt::cpuRelax();
+            }
+            producer.push({ next });
+        }
+        while (received.load(std::memory_order_acquire) < count)
+        {
+            std::this_thread::yield();
+        }
+        producer.disableWorkerThread();
+        consumer.disableWorkerThread();
+
+        std::cout << "jitter realtime=" << options.enabled << " cpu=" << options.cpu
+            << " interval=" << intervalNs << "ns" << std::endl;
+        std::cout << " inter-arrival" << std::endl;
+        interArrival.print(std::cout);
+        std::cout << " latency" << std::endl;
+        latency.print(std::cout);
+    }
+} // namespace
+
+// Usage: Benchmark [--json <path>] [--repetitions <n>] [benchmark names...]
+int main(int argc, char* argv[])
+{
+    std::string jsonPath;
+    std::size_t repetitions = 1;
+    std::vector<std::string_view> names;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--json" && i + 1 < argc)
+        {
+            jsonPath = argv[++i];
+        }
+        else if (arg == "--repetitions" && i + 1 < argc)
+        {
+            repetitions = std::max<std::size_t>(std::strtoul(argv[++i], nullptr, 10), 1);
+        }
+        else
+        {
+            names.push_back(arg);
+        }
+    }
+    const auto selected = [&](const std::string_view name)
+        {
+            return names.empty() || std::find(names.cbegin(), names.cend(), name) != names.cend();
+        };
+
+    Results results;
+    for (std::size_t repetition = 0; repetition < repetitions; ++repetition)
+    {
+        if (selected("push_pop"))
+        {
+            pushPopBenchmarks(results, 1'000'000);
+        }
+        if (selected("throughput"))
+        {
+            throughputBenchmarks(results, 1'000'000);
+        }
+        if (selected("toggle"))
+        {
+            toggleBenchmark(results, 200);
+        }
+    }
+    if (!jsonPath.empty())
+    {
+        results.writeJson(jsonPath, repetitions);
+    }
+
+    if (selected("jitter"))
+    {
+        jitterBenchmark(mt::RealTimeOptions{}, 20'000, 20'000);
+
+        // The producer is pinned to cpu and the consumer to cpu + 1, so both must be usable here.
+        int cpu = -1;
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (::sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+        {
+            for (int candidate = CPU_SETSIZE - 2; candidate >= 0 && cpu < 0; --candidate)
+            {
+                if (CPU_ISSET(candidate, &allowed) && CPU_ISSET(candidate + 1, &allowed))
+                {
+                    cpu = candidate;
+                }
+            }
+        }
+        if (cpu < 0)
+        {
+            std::cout << "jitter realtime skipped: needs two adjacent CPUs for the producer and the consumer" << std::endl;
+        }
+        else
+        {
+            jitterBenchmark(mt::RealTimeOptions{ .enabled = true, .cpu = cpu }, 20'000, 20'000);
+        }
+    }
+}
@@ -0,0 +1,406 @@
+/**
+ * @file BenchmarkCompare.cpp
+ *
+ * @brief Compares two Benchmark JSON result files and flags statistically significant regressions.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    struct MalformedResults : std::exception
+    {
+        [[nodiscard]] const char* what() const noexcept override { return "Exception: Malformed benchmark results"; }
+    };
+
+    struct Result
+    {
+        std::string unit;
+        bool higherIsBetter = true;
+        std::vector<double> samples;
+    };
+
+    // Reads just the subset of JSON that Benchmark writes: the "results" array of objects with
+    // name, unit, higher_is_better and samples. Everything else, such as the environment, is skipped.
+    class ResultsReader
+    {
+    private:
+        std::string_view m_text;
+        std::size_t m_pos = 0;
+
+    public:
+        explicit ResultsReader(const std::string_view text)
+            : m_text(text)
+        {
+        }
+        ResultsReader(const ResultsReader&) = delete;
+        ResultsReader(ResultsReader&&) = delete;
+        ResultsReader& operator=(const ResultsReader&) = delete;
+        ResultsReader& operator=(ResultsReader&&) = delete;
+        ~ResultsReader() = default;
+
+        [[nodiscard]] std::map<std::string, Result> read()
+        {
+            std::map<std::string, Result> results;
+            expect('{');
+            while (!consume('}'))
+            {
+                const std::string key = readString();
+                expect(':');
+                if (key == "results")
+                {
+                    expect('[');
+                    while (!consume(']'))
+                    {
+                        std::string name;
+                        const Result result = readResult(name);
+                        results[name] = result;
+                        consume(',');
+                    }
+                }
+                else
+                {
+                    skipValue();
+                }
+                consume(',');
+            }
+            return results;
+        }
+
+    private:
+        void skipSpace()
+        {
+            while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos])))
+            {
+                ++m_pos;
+            }
+        }
+
+        bool consume(const char c)
+        {
+            skipSpace();
+            if (m_pos < m_text.size() && m_text[m_pos] == c)
+            {
+                ++m_pos;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(const char c)
+        {
+            if (!consume(c))
+            {
+                throw MalformedResults{};
+            }
+        }
+
+        [[nodiscard]] std::string readString()
+        {
+            expect('"');
+            std::string value;
+            while (m_pos < m_text.size() && m_text[m_pos] != '"')
+            {
+                if (m_text[m_pos] == '\\' && m_pos + 1 < m_text.size())
+                {
+                    ++m_pos;
+                }
+                value += m_text[m_pos++];
+            }
+            expect('"');
+            return value;
+        }
+
+        [[nodiscard]] double readNumber()
+        {
+            skipSpace();
+            const std::string rest(m_text.substr(m_pos, 64));
+            char* end = nullptr;
+            const double value = std::strtod(rest.c_str(), &end);
+            if (end == rest.c_str())
+            {
+                throw MalformedResults{};
+            }
+            m_pos += static_cast<std::size_t>(end - rest.c_str());
+            return value;
+        }
+
+        [[nodiscard]] bool readBool()
+        {
+            skipSpace();
+            if (m_text.substr(m_pos, 4) == "true")
+            {
+                m_pos += 4;
+                return true;
+            }
+            if (m_text.substr(m_pos, 5) == "false")
+            {
+                m_pos += 5;
+                return false;
+            }
+            throw MalformedResults{};
+        }
+
+        void skipValue()
+        {
+            skipSpace();
+            if (m_pos >= m_text.size())
+            {
+                throw MalformedResults{};
+            }
+            const char c = m_text[m_pos];
+            if (c == '"')
+            {
+                static_cast<void>(readString());
+            }
+            else if (c == '{' || c == '[')
+            {
+                const char close = c == '{' ? '}' : ']';
+                ++m_pos;
+                while (!consume(close))
+                {
+                    if (c == '{')
+                    {
+                        static_cast<void>(readString());
+                        expect(':');
+                    }
+                    skipValue();
+                    consume(',');
+                }
+            }
+            else if (c == 't' || c == 'f')
+            {
+                static_cast<void>(readBool());
+            }
+            else
+            {
+                static_cast<void>(readNumber());
+            }
+        }
+
+        [[nodiscard]] Result readResult(std::string& name)
+        {
+            Result result;
+            expect('{');
+            while (!consume('}'))
+            {
+                const std::string key = readString();
+                expect(':');
+                if (key == "name")
+                {
+                    name = readString();
+                }
+                else if (key == "unit")
+                {
+                    result.unit = readString();
+                }
+                else if (key == "higher_is_better")
+                {
+                    result.higherIsBetter = readBool();
+                }
+                else if (key == "samples")
+                {
+                    expect('[');
+                    while (!consume(']'))
+                    {
+                        result.samples.push_back(readNumber());
+                        consume(',');
+                    }
+                }
+                else
+                {
+                    skipValue();
+                }
+                consume(',');
+            }
+            return result;
+        }
+    };
+
+    [[nodiscard]] std::map<std::string, Result> readResults(const std::string& path)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return ResultsReader(text).read();
+    }
+
+    struct Summary
+    {
+        double mean = 0.0;
+        double variance = 0.0;
+        std::size_t count = 0;
+    };
+
+    [[nodiscard]] Summary summarize(const std::vector<double>& samples)
+    {
+        Summary summary;
+        summary.count = samples.size();
+        for (const double sample : samples)
+        {
+            summary.mean += sample;
+        }
+        summary.mean /= static_cast<double>(summary.count);
+        if (summary.count > 1)
+        {
+            for (const double sample : samples)
+            {
+                summary.variance += (sample - summary.mean) * (sample - summary.mean);
+            }
+            summary.variance /= static_cast<double>(summary.count - 1);
+        }
+        return summary;
+    }
+
+    // Two-sided 97.5% quantile of Student's t with df degrees of freedom. Below 30 it is taken from
+    // the exact table at floor(df), which errs towards a wider interval for the fractional Welch df;
+    // above, the Cornish-Fisher expansion from the normal quantile is within 1e-6 of the exact value.
+    [[nodiscard]] double tQuantile975(const double df)
+    {
+        constexpr double Table[] = { 12.706205, 4.302653, 3.182446, 2.776445, 2.570582, 2.446912, 2.364624, 2.306004,
+            2.262157, 2.228139, 2.200985, 2.178813, 2.160369, 2.144787, 2.131450, 2.119905, 2.109816, 2.100922, 2.093024,
+            2.085963, 2.079614, 2.073873, 2.068658, 2.063899, 2.059539, 2.055529, 2.051831, 2.048407, 2.045230, 2.042272 };
+        constexpr std::size_t TableSize = std::size(Table);
+        if (df < static_cast<double>(TableSize))
+        {
+            const auto index = static_cast<std::size_t>(std::max(std::floor(df), 1.0)) - 1;
+            return Table[index];
+        }
+        constexpr double z = 1.959963984540054;
+        const double z3 = z * z * z;
+        const double z5 = z3 * z * z;
+        const double z7 = z5 * z * z;
+        return z + (z3 + z) / (4.0 * df) + (5.0 * z5 + 16.0 * z3 + 3.0 * z) / (96.0 * df * df)
+            + (3.0 * z7 + 19.0 * z5 + 17.0 * z3 - 15.0 * z) / (384.0 * df * df * df);
+    }
+
+    struct Comparison
+    {
+        double change;
+        double low;
+        double high;
+        bool significant;
+    };
+
+    // Welch's t-test on the difference of means, with the Welch-Satterthwaite degrees of freedom.
+    // change, low and high are relative to the baseline mean; the interval is a 95% confidence
+    // interval, and significant means it excludes zero.
+    [[nodiscard]] Comparison compare(const Summary& baseline, const Summary& candidate)
+    {
+        const double difference = candidate.mean - baseline.mean;
+        const double baselineError = baseline.variance / static_cast<double>(baseline.count);
+        const double candidateError = candidate.variance / static_cast<double>(candidate.count);
+        const double standardError = std::sqrt(baselineError + candidateError);
+        Comparison comparison{ difference / baseline.mean, difference / baseline.mean, difference / baseline.mean, false };
+        if (baseline.count < 2 || candidate.count < 2 || standardError == 0.0)
+        {
+            return comparison;
+        }
+        const double df = (baselineError + candidateError) * (baselineError + candidateError)
+            / (baselineError * baselineError / static_cast<double>(baseline.count - 1)
+                + candidateError * candidateError / static_cast<double>(candidate.count - 1));
+        const double margin = tQuantile975(df) * standardError;
+        comparison.low = (difference - margin) / baseline.mean;
+        comparison.high = (difference + margin) / baseline.mean;
+        comparison.significant = comparison.low > 0.0 || comparison.high < 0.0;
+        return comparison;
+    }
+} // namespace
+
+// Usage: BenchmarkCompare <baseline.json> <candidate.json> [--threshold <percent>]
+// Exits with 1 when any result got worse by more than the threshold (5% by default) with a
+// confidence interval that excludes no change. Results need at least two repetitions to be judged.
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <baseline.json> <candidate.json> [--threshold <percent>]" << std::endl;
+        return 2;
+    }
+    double threshold = 0.05;
+    for (int i = 3; i + 1 < argc; ++i)
+    {
+        if (std::string_view(argv[i]) == "--threshold")
+        {
+            threshold = std::strtod(argv[++i], nullptr) / 100.0;
+        }
+    }
+
+    try
+    {
+        const auto baseline = readResults(argv[1]);
+        const auto candidate = readResults(argv[2]);
+        std::size_t regressions = 0;
+        std::cout << std::left << std::setw(36) << "benchmark" << std::right << std::setw(16) << "baseline"
+            << std::setw(16) << "candidate" << std::setw(10) << "change" << std::setw(22) << "95% CI" << "  verdict\n";
+        for (const auto& [name, result] : baseline)
+        {
+            const auto it = candidate.find(name);
+            if (it == candidate.cend() || result.samples.empty() || it->second.samples.empty())
+            {
+                std::cout << std::left << std::setw(36) << name << " missing from one of the runs\n";
+                continue;
+            }
+            const Summary before = summarize(result.samples);
+            const Summary after = summarize(it->second.samples);
+            const Comparison comparison = compare(before, after);
+            const double worse = result.higherIsBetter ? -comparison.change : comparison.change;
+            const char* verdict = "unchanged";
+            if (!comparison.significant)
+            {
+                verdict = before.count < 2 || after.count < 2 ? "too few samples" : "unchanged";
+            }
+            else if (worse > threshold)
+            {
+                verdict = "REGRESSION";
+                ++regressions;
+            }
+            else if (-worse > threshold)
+            {
+                verdict = "improvement";
+            }
+            else
+            {
+                verdict = "within threshold";
+            }
+
+            std::ostringstream interval;
+            interval << std::fixed << std::setprecision(1) << std::showpos << '[' << comparison.low * 100.0 << "%, "
+                << comparison.high * 100.0 << "%]";
+            std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1)
+                << std::setw(16) << before.mean << std::setw(16) << after.mean << std::showpos << std::setw(9)
+                << comparison.change * 100.0 << '%' << std::noshowpos << std::setw(22) << interval.str() << "  " << verdict
+                << " (" << result.unit << ")\n";
+        }
+        std::cout << regressions << " regression(s)" << std::endl;
+        return regressions == 0 ? 0 : 1;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "BenchmarkCompare -> " << ex.what() << std::endl;
+        return 2;
+    }
+}
@@ -12,10 +12,57 @@
 #ifndef CONSUMER_H
 #define CONSUMER_H
 
+#include "ForkJoinPool.h"
+#include "Metrics.h"
 #include "ProducerConsumerBase.h"
+#include "Reply.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
 
 namespace mt
 {
+    // In adaptive mode the consumer drains batches of items per adapter interaction. The batch
+    // grows additively while there is backlog and the batch was processed within latencyBudget,
+    // and is halved whenever processing exceeded the budget. In parallel mode every drained batch
+    // is spread over the shared ForkJoinPool in chunks of parallelGrain items, so the callable
+    // must be safe to call concurrently; without adaptive the batch size stays at maxBatch.
+    struct BatchOptions
+    {
+        bool adaptive = false;
+        bool parallel = false;
+        std::size_t parallelGrain = 16;
+        std::size_t minBatch = 1;
+        std::size_t maxBatch = 1024;
+        std::size_t increment = 1;
+        std::chrono::microseconds latencyBudget{ 1000 };
+    };
+
+    // Applies to Expiring elements. With shedHopeless the consumer drops an item whose deadline
+    // is closer than the expected service time, an EWMA of past callable durations.
+    struct DeadlineOptions
+    {
+        bool shedHopeless = false;
+        double serviceTimeWeight = 0.125;
+    };
+
+    struct DeadlineStats
+    {
+        std::uint64_t met = 0;
+        std::uint64_t missed = 0;
+        std::uint64_t shed = 0;
+
+        [[nodiscard]] double missRate() const noexcept
+        {
+            const std::uint64_t total = met + missed + shed;
+            return total == 0 ? 0.0 : static_cast<double>(missed + shed) / static_cast<double>(total);
+        }
+    };
+
     template<typename Adapter, typename Callable>
     class Consumer : public ProducerConsumerBase<Adapter>
     {
@@ -24,6 +71,16 @@ namespace mt
         using Elem = typename Adapter::Elem;
 
         Callable m_callable;
+        BatchOptions m_batchOptions;
+        BatchOptions m_workerBatchOptions;
+        DeadlineOptions m_deadlineOptions;
+        DeadlineOptions m_workerDeadlineOptions;
+        std::atomic<std::int64_t> m_serviceTimeNs{ 0 };
+        std::atomic<std::uint64_t> m_deadlinesMet{ 0 };
+        std::atomic<std::uint64_t> m_deadlinesMissed{ 0 };
+        std::atomic<std::uint64_t> m_deadlinesShed{ 0 };
+        LatencyHistogram* m_latencyHistogram = nullptr;
+        LatencyHistogram* m_workerLatencyHistogram = nullptr;
 
     public:
         explicit Consumer(Adapter& sharedContainer, Callable callable);
@@ -33,8 +90,17 @@ namespace mt
         Consumer& operator=(Consumer&) = default;
         ~Consumer() override;
 
+        void setBatchOptions(const BatchOptions& options);
+        void setDeadlineOptions(const DeadlineOptions& options);
+        [[nodiscard]] DeadlineStats deadlineStats() const noexcept;
+        void setLatencyHistogram(LatencyHistogram* histogram);
+
     private:
         void workerThreadWork() override;
+        void prepareWorkerThread() override;
+        void batchWork();
+        void consume(Elem&& item);
+        void consumeBeforeDeadline(Elem&& item);
     };
 
     template<typename Adapter, typename Callable>
@@ -51,18 +117,175 @@ namespace mt
         this->shutdownMainThread();
     }
 
+    // Takes effect the next time the worker thread is enabled.
+    template<typename Adapter, typename Callable>
+    void Consumer<Adapter, Callable>::setBatchOptions(const BatchOptions& options)
+    {
+        std::lock_guard<std::mutex> lock(this->m_workerThreadMutex);
+        m_batchOptions = options;
+    }
+
+    // Takes effect the next time the worker thread is enabled.
+    template<typename Adapter, typename Callable>
+    void Consumer<Adapter, Callable>::setDeadlineOptions(const DeadlineOptions& options)
+    {
+        std::lock_guard<std::mutex> lock(this->m_workerThreadMutex);
+        m_deadlineOptions = options;
+    }
+
+    // Records the duration of every callable invocation into histogram, which must outlive the worker; nullptr stops it.
+    // Takes effect the next time the worker thread is enabled.
+    template<typename Adapter, typename Callable>
+    void Consumer<Adapter, Callable>::setLatencyHistogram(LatencyHistogram* const histogram)
+    {
+        std::lock_guard<std::mutex> lock(this->m_workerThreadMutex);
+        m_latencyHistogram = histogram;
+    }
+
+    // Items dropped by the adapter because they had already expired are counted by its expiredCount.
+    template<typename Adapter, typename Callable>
+    DeadlineStats Consumer<Adapter, Callable>::deadlineStats() const noexcept
+    {
+        return DeadlineStats{ m_deadlinesMet.load(std::memory_order_relaxed), m_deadlinesMissed.load(std::memory_order_relaxed),
+            m_deadlinesShed.load(std::memory_order_relaxed) };
+    }
+
+    template<typename Adapter, typename Callable>
+    void Consumer<Adapter, Callable>::prepareWorkerThread()
+    {
+        m_workerBatchOptions = m_batchOptions;
+        m_workerDeadlineOptions = m_deadlineOptions;
+        m_workerLatencyHistogram = m_latencyHistogram;
+    }
+
+    template<typename Adapter, typename Callable>
+    void Consumer<Adapter, Callable>::consume(Elem&& item)
+    {
+        TraceScope scope("Consumer::callable");
+        const auto start = m_workerLatencyHistogram ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+        if constexpr (IsRequest<Elem>::value)
+        {
+            item.complete(m_callable);
+        }
+        else if constexpr (IsExpiring<Elem>::value)
+        {
+            consumeBeforeDeadline(std::move(item));
+        }
+        else if constexpr (IsPrioritized<Elem>::value && !std::is_invocable_v<Callable&, Elem&&>)
+        {
+            m_callable(std::move_if_noexcept(item.value));
+        }
+        else
+        {
+            m_callable(std::move_if_noexcept(item));
+        }
+        if (m_workerLatencyHistogram)
+        {
+            m_workerLatencyHistogram->record(std::chrono::steady_clock::now() - start);
+        }
+    }
+
+    template<typename Adapter, typename Callable>
+    void Consumer<Adapter, Callable>::consumeBeforeDeadline(Elem&& item)
+    {
+        using Clock = typename Elem::Clock;
+        const auto start = Clock::now();
+        const std::chrono::nanoseconds serviceTime(m_serviceTimeNs.load(std::memory_order_relaxed));
+        if (m_workerDeadlineOptions.shedHopeless && item.deadline - start < serviceTime)
+        {
+            m_deadlinesShed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        const auto deadline = item.deadline;
+        if constexpr (std::is_invocable_v<Callable&, Elem&&>)
+        {
+            m_callable(std::move_if_noexcept(item));
+        }
+        else
+        {
+            m_callable(std::move_if_noexcept(item.value));
+        }
+        const auto finish = Clock::now();
+        const double weight = m_workerDeadlineOptions.serviceTimeWeight;
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count();
+        // Parallel batches run this on several pool threads, so each sample is folded into the
+        // latest average rather than the one read before the call.
+        std::int64_t average = m_serviceTimeNs.load(std::memory_order_relaxed);
+        std::int64_t updated;
+        do
+        {
+            updated = static_cast<std::int64_t>((1.0 - weight) * static_cast<double>(average) + weight * static_cast<double>(elapsed));
+        } while (!m_serviceTimeNs.compare_exchange_weak(average, updated, std::memory_order_relaxed));
+        (finish <= deadline ? m_deadlinesMet : m_deadlinesMissed).fetch_add(1, std::memory_order_relaxed);
+    }
+
     template<typename Adapter, typename Callable>
     void Consumer<Adapter, Callable>::workerThreadWork()
     {
+        if (m_workerBatchOptions.adaptive || m_workerBatchOptions.parallel)
+        {
+            batchWork();
+            return;
+        }
         while (this->m_workerThreadEnabled)
         {
             if (Elem item; this->m_sharedContainer.tryPop(item))
             {
-                m_callable(std::move_if_noexcept(item));
+                consume(std::move(item));
+                this->onWork();
+            }
+            else
+            {
+                this->onIdle();
+            }
+        }
+    }
+
+    template<typename Adapter, typename Callable>
+    void Consumer<Adapter, Callable>::batchWork()
+    {
+        const BatchOptions& options = m_workerBatchOptions;
+        const std::size_t minBatch = std::max<std::size_t>(options.minBatch, 1);
+        const std::size_t maxBatch = std::max(options.maxBatch, minBatch);
+        std::size_t batchSize = options.adaptive ? minBatch : maxBatch;
+        std::vector<Elem> batch;
+        batch.reserve(maxBatch);
+        const auto consumeAt = [&](const std::size_t i) { consume(std::move(batch[i])); };
+        while (this->m_workerThreadEnabled)
+        {
+            if (this->m_sharedContainer.tryPopBatch(batch, batchSize) != 0)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                if (options.parallel)
+                {
+                    ForkJoinPool::shared().parallelFor(batch.size(), options.parallelGrain, consumeAt);
+                }
+                else
+                {
+                    for (auto& item : batch)
+                    {
+                        consume(std::move(item));
+                    }
+                }
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                batch.clear();
+
+                if (options.adaptive)
+                {
+                    if (elapsed > options.latencyBudget)
+                    {
+                        batchSize = std::max(batchSize / 2, minBatch);
+                    }
+                    else if (!this->m_sharedContainer.emptyApprox())
+                    {
+                        batchSize = std::min(batchSize + options.increment, maxBatch);
+                    }
+                }
+                this->onWork();
             }
             else
             {
-                std::this_thread::yield();
+                this->onIdle();
             }
         }
     }
@@ -0,0 +1,226 @@
+/**
+ * @file FairQueueAdapter.h
+ *
+ * @brief FairQueueAdapter class for multi-tenant fair queuing with deficit round robin dequeue.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef FAIR_QUEUE_ADAPTER_H
+#define FAIR_QUEUE_ADAPTER_H
+
+#include "ThreadSafeSTLAdapter.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mt
+{
+    template<typename T, typename Tenant = std::uint32_t>
+    struct TenantItem
+    {
+        Tenant tenant{};
+        T value{};
+        std::size_t cost = 1;
+    };
+
+    // Every tenant has its own FIFO sub-queue. Active sub-queues are served in round robin order,
+    // each receiving quantum credit per turn and spending it on the cost of its items, so a
+    // bursting tenant cannot delay the others by more than one quantum per round.
+    template<typename T, typename Tenant = std::uint32_t, typename Hash = std::hash<Tenant>>
+    class FairQueueAdapter
+    {
+    public:
+        using Elem = TenantItem<T, Tenant>;
+
+    private:
+        struct SubQueue
+        {
+            std::deque<Elem> items;
+            std::size_t deficit = 0;
+            bool hasTurn = false;
+        };
+
+        std::unordered_map<Tenant, SubQueue, Hash> m_subQueues;
+        std::deque<SubQueue*> m_activeSubQueues;
+        std::size_t m_quantum;
+        std::atomic<std::size_t> m_size{ 0 };
+        std::mutex m_mutex;
+        std::condition_variable m_condVar;
+
+    public:
+        explicit FairQueueAdapter(std::size_t quantum = 1);
+        FairQueueAdapter(const FairQueueAdapter&) = delete;
+        FairQueueAdapter(FairQueueAdapter&&) = delete;
+        FairQueueAdapter& operator=(const FairQueueAdapter&) = delete;
+        FairQueueAdapter& operator=(FairQueueAdapter&&) = delete;
+        ~FairQueueAdapter() = default;
+
+        void push(Elem value);
+        void pushAndNotify(Elem value);
+
+        void waitAndPop(Elem& value);
+        std::shared_ptr<Elem> waitAndPop();
+
+        bool tryPop(Elem& value);
+        std::shared_ptr<Elem> tryPop();
+        std::size_t tryPopBatch(std::vector<Elem>& values, std::size_t maxCount);
+
+        void pop(Elem& value);
+        std::shared_ptr<Elem> pop();
+
+        [[nodiscard]] std::size_t sizeApprox() const noexcept;
+        [[nodiscard]] bool emptyApprox() const noexcept;
+
+    private:
+        void takeNextLocked(Elem& value);
+    };
+
+    template<typename T, typename Tenant, typename Hash>
+    FairQueueAdapter<T, Tenant, Hash>::FairQueueAdapter(const std::size_t quantum)
+        : m_quantum(quantum == 0 ? 1 : quantum)
+    { }
+
+    template<typename T, typename Tenant, typename Hash>
+    void FairQueueAdapter<T, Tenant, Hash>::push(Elem value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        SubQueue& subQueue = m_subQueues[value.tenant];
+        if (subQueue.items.empty())
+        {
+            m_activeSubQueues.push_back(&subQueue);
+        }
+        subQueue.items.push_back(std::move_if_noexcept(value));
+        m_size.store(m_size.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    template<typename T, typename Tenant, typename Hash>
+    void FairQueueAdapter<T, Tenant, Hash>::pushAndNotify(Elem value)
+    {
+        push(std::move_if_noexcept(value));
+        m_condVar.notify_one();
+    }
+
+    template<typename T, typename Tenant, typename Hash>
+    void FairQueueAdapter<T, Tenant, Hash>::waitAndPop(Elem& value)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condVar.wait(lock, [&] { return !m_activeSubQueues.empty(); });
+        takeNextLocked(value);
+    }
+
+    template<typename T, typename Tenant, typename Hash>
+    std::shared_ptr<typename FairQueueAdapter<T, Tenant, Hash>::Elem> FairQueueAdapter<T, Tenant, Hash>::waitAndPop()
+    {
+        Elem value;
+        waitAndPop(value);
+        return std::make_shared<Elem>(std::move(value));
+    }
+
+    template<typename T, typename Tenant, typename Hash>
+    bool FairQueueAdapter<T, Tenant, Hash>::tryPop(Elem& value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_activeSubQueues.empty())
+        {
+            return false;
+        }
+        takeNextLocked(value);
+        return true;
+    }
+
+    template<typename T, typename Tenant, typename Hash>
+    std::shared_ptr<typename FairQueueAdapter<T, Tenant, Hash>::Elem> FairQueueAdapter<T, Tenant, Hash>::tryPop()
+    {
+        if (Elem value; tryPop(value))
+        {
+            return std::make_shared<Elem>(std::move(value));
+        }
+        return std::shared_ptr<Elem>{};
+    }
+
+    template<typename T, typename Tenant, typename Hash>
+    std::size_t FairQueueAdapter<T, Tenant, Hash>::tryPopBatch(std::vector<Elem>& values, const std::size_t maxCount)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::size_t count = 0;
+        for (; count < maxCount && !m_activeSubQueues.empty(); ++count)
+        {
+            takeNextLocked(values.emplace_back());
+        }
+        return count;
+    }
+
+    template<typename T, typename Tenant, typename Hash>
+    void FairQueueAdapter<T, Tenant, Hash>::pop(Elem& value)
+    {
+        if (!tryPop(value))
+        {
+            throw EmptyAdapter{};
+        }
+    }
+
+    template<typename T, typename Tenant, typename Hash>
+    std::shared_ptr<typename FairQueueAdapter<T, Tenant, Hash>::Elem> FairQueueAdapter<T, Tenant, Hash>::pop()
+    {
+        Elem value;
+        pop(value);
+        return std::make_shared<Elem>(std::move(value));
+    }
+
+    template<typename T, typename Tenant, typename Hash>
+    std::size_t FairQueueAdapter<T, Tenant, Hash>::sizeApprox() const noexcept
+    {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    template<typename T, typename Tenant, typename Hash>
+    bool FairQueueAdapter<T, Tenant, Hash>::emptyApprox() const noexcept
+    {
+        return sizeApprox() == 0;
+    }
+
+    template<typename T, typename Tenant, typename Hash>
+    void FairQueueAdapter<T, Tenant, Hash>::takeNextLocked(Elem& value)
+    {
+        while (true)
+        {
+            SubQueue& subQueue = *m_activeSubQueues.front();
+            if (!subQueue.hasTurn)
+            {
+                subQueue.deficit += m_quantum;
+                subQueue.hasTurn = true;
+            }
+            if (const std::size_t cost = subQueue.items.front().cost; cost <= subQueue.deficit)
+            {
+                subQueue.deficit -= cost;
+                value = std::move_if_noexcept(subQueue.items.front());
+                subQueue.items.pop_front();
+                if (subQueue.items.empty())
+                {
+                    // Drained tenants are forgotten, so the map only holds tenants with queued items.
+                    m_activeSubQueues.pop_front();
+                    m_subQueues.erase(value.tenant);
+                }
+                m_size.store(m_size.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+                return;
+            }
+            subQueue.hasTurn = false;
+            m_activeSubQueues.pop_front();
+            m_activeSubQueues.push_back(&subQueue);
+        }
+    }
+} // namespace mt
+
+#endif
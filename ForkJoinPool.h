@@ -0,0 +1,198 @@
+/**
+ * @file ForkJoinPool.h
+ *
+ * @brief ForkJoinPool class for running a loop over a batch on several threads and joining.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef FORK_JOIN_POOL_H
+#define FORK_JOIN_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mt
+{
+    // Fixed set of helper threads that join the calling thread on one parallelFor at a time.
+    // The caller always takes part, so a pool without helpers simply runs the loop inline.
+    class ForkJoinPool
+    {
+    private:
+        struct Job
+        {
+            void (*run)(void* context, std::size_t begin, std::size_t end);
+            void* context;
+            std::size_t count;
+            std::size_t grain;
+        };
+
+        std::vector<std::jthread> m_threads;
+        std::mutex m_submitMutex;
+        std::mutex m_mutex;
+        std::condition_variable m_condVar;
+        std::condition_variable m_joinCondVar;
+        const Job* m_job = nullptr;
+        std::uint64_t m_generation = 0;
+        std::size_t m_active = 0;
+        bool m_stop = false;
+        std::atomic<std::size_t> m_next{ 0 };
+        std::exception_ptr m_exception;
+
+        // The pool whose job the current thread is working on, if any.
+        inline static thread_local const ForkJoinPool* s_current = nullptr;
+
+    public:
+        explicit ForkJoinPool(std::size_t helpers = std::max(std::thread::hardware_concurrency(), 1u) - 1);
+        ForkJoinPool(const ForkJoinPool&) = delete;
+        ForkJoinPool(ForkJoinPool&&) = delete;
+        ForkJoinPool& operator=(const ForkJoinPool&) = delete;
+        ForkJoinPool& operator=(ForkJoinPool&&) = delete;
+        ~ForkJoinPool();
+
+        static ForkJoinPool& shared();
+
+        [[nodiscard]] std::size_t helpers() const noexcept { return m_threads.size(); }
+
+        // Calls fn(i) for every i in [0, count), handing out chunks of grain indices. The first
+        // exception thrown by fn is rethrown here once every started chunk has finished. Calls from
+        // within fn, from one of this pool's helpers, or made while another caller's job occupies
+        // the pool run inline instead of waiting for the pool.
+        template<typename Fn>
+        void parallelFor(std::size_t count, std::size_t grain, Fn&& fn);
+
+    private:
+        void helperThreadWork();
+        void runChunks(const Job& job);
+    };
+
+    inline ForkJoinPool::ForkJoinPool(const std::size_t helpers)
+    {
+        m_threads.reserve(helpers);
+        for (std::size_t i = 0; i < helpers; ++i)
+        {
+            m_threads.emplace_back([this] { helperThreadWork(); });
+        }
+    }
+
+    inline ForkJoinPool::~ForkJoinPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_condVar.notify_all();
+        m_threads.clear();
+    }
+
+    inline ForkJoinPool& ForkJoinPool::shared()
+    {
+        static ForkJoinPool pool;
+        return pool;
+    }
+
+    template<typename Fn>
+    void ForkJoinPool::parallelFor(const std::size_t count, const std::size_t grain, Fn&& fn)
+    {
+        using Function = std::remove_reference_t<Fn>;
+        const Job job{ [](void* const context, const std::size_t begin, const std::size_t end)
+            {
+                Function& fn = *static_cast<Function*>(context);
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    fn(i);
+                }
+            }, const_cast<void*>(static_cast<const void*>(std::addressof(fn))), count, std::max<std::size_t>(grain, 1) };
+        std::unique_lock<std::mutex> submitLock(m_submitMutex, std::defer_lock);
+        if (m_threads.empty() || count <= job.grain || s_current == this || !submitLock.try_lock())
+        {
+            job.run(job.context, 0, count);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_next.store(0, std::memory_order_relaxed);
+            m_exception = nullptr;
+            m_job = &job;
+            ++m_generation;
+        }
+        m_condVar.notify_all();
+        const ForkJoinPool* const outer = std::exchange(s_current, this);
+        runChunks(job);
+        s_current = outer;
+
+        // Retire the job only after every helper that picked it up has left, so none can touch it later.
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_joinCondVar.wait(lock, [&] { return m_active == 0; });
+        m_job = nullptr;
+        if (m_exception)
+        {
+            std::rethrow_exception(std::exchange(m_exception, nullptr));
+        }
+    }
+
+    inline void ForkJoinPool::helperThreadWork()
+    {
+        s_current = this;
+        std::uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_condVar.wait(lock, [&] { return m_stop || (m_job && m_generation != seen); });
+            if (m_stop)
+            {
+                return;
+            }
+            seen = m_generation;
+            const Job& job = *m_job;
+            ++m_active;
+            lock.unlock();
+            runChunks(job);
+            lock.lock();
+            if (--m_active == 0)
+            {
+                m_joinCondVar.notify_one();
+            }
+        }
+    }
+
+    inline void ForkJoinPool::runChunks(const Job& job)
+    {
+        while (true)
+        {
+            const std::size_t begin = m_next.fetch_add(job.grain, std::memory_order_relaxed);
+            if (begin >= job.count)
+            {
+                return;
+            }
+            try
+            {
+                job.run(job.context, begin, std::min(begin + job.grain, job.count));
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_exception)
+                {
+                    m_exception = std::current_exception();
+                }
+            }
+        }
+    }
+} // namespace mt
+
+#endif
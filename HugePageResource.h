@@ -0,0 +1,156 @@
+/**
+ * @file HugePageResource.h
+ *
+ * @brief HugePageResource memory resource for backing adapter storage with huge, pre-faulted pages.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef HUGE_PAGE_RESOURCE_H
+#define HUGE_PAGE_RESOURCE_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mt
+{
+    struct HugePageOptions
+    {
+        std::size_t size = std::size_t{ 64 } << 20;
+        bool prefault = true;
+        bool lock = false;
+    };
+
+    // Monotonic arena over a single mapping. Use it as the upstream of a std::pmr pool resource
+    // so that freed blocks are recycled instead of consuming the region.
+    // Usage:
+    //     mt::HugePageResource hugePages({ .size = 256 << 20, .lock = true });
+    //     std::pmr::synchronized_pool_resource pool(&hugePages);
+    //     auto adapter = mt::createThreadSafeSTLAdapterFrom(std::queue<int, std::pmr::deque<int>>{ &pool });
+    class HugePageResource : public std::pmr::memory_resource
+    {
+    private:
+        static constexpr std::size_t HugePageSize = std::size_t{ 2 } << 20;
+
+        std::byte* m_begin = nullptr;
+        std::byte* m_end = nullptr;
+        std::byte* m_current = nullptr;
+        bool m_hugeTlb = false;
+        bool m_locked = false;
+        std::pmr::memory_resource* m_upstream;
+        std::mutex m_mutex;
+
+    public:
+        explicit HugePageResource(const HugePageOptions& options = {},
+            std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+        HugePageResource(const HugePageResource&) = delete;
+        HugePageResource(HugePageResource&&) = delete;
+        HugePageResource& operator=(const HugePageResource&) = delete;
+        HugePageResource& operator=(HugePageResource&&) = delete;
+        ~HugePageResource() override;
+
+        [[nodiscard]] bool usesHugeTlb() const noexcept { return m_hugeTlb; }
+        [[nodiscard]] bool isLocked() const noexcept { return m_locked; }
+        [[nodiscard]] std::size_t capacity() const noexcept { return static_cast<std::size_t>(m_end - m_begin); }
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+        [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    inline HugePageResource::HugePageResource(const HugePageOptions& options, std::pmr::memory_resource* upstream)
+        : m_upstream(upstream)
+    {
+        const std::size_t size = (options.size + HugePageSize - 1) / HugePageSize * HugePageSize;
+        const int populate = options.prefault ? MAP_POPULATE : 0;
+        void* region = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate, -1, 0);
+        m_hugeTlb = region != MAP_FAILED;
+        if (!m_hugeTlb)
+        {
+            // No reserved huge pages; fall back to transparent huge pages.
+            region = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (region == MAP_FAILED)
+            {
+                throw std::bad_alloc{};
+            }
+            ::madvise(region, size, MADV_HUGEPAGE);
+
+            // MAP_POPULATE would fault the pages in before madvise could make them huge, so the
+            // fallback touches them itself; the huge TLB mapping above is already populated.
+            if (options.prefault)
+            {
+                const std::size_t pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+                for (std::byte* page = static_cast<std::byte*>(region); page < static_cast<std::byte*>(region) + size; page += pageSize)
+                {
+                    *static_cast<volatile std::byte*>(page) = std::byte{ 0 };
+                }
+            }
+        }
+        m_begin = static_cast<std::byte*>(region);
+        m_end = m_begin + size;
+        m_current = m_begin;
+
+        if (options.lock)
+        {
+            if (::mlock(m_begin, size) != 0)
+            {
+                const int error = errno;
+                ::munmap(m_begin, size);
+                throw std::system_error(error, std::generic_category(), "mlock");
+            }
+            m_locked = true;
+        }
+    }
+
+    inline HugePageResource::~HugePageResource()
+    {
+        if (m_locked)
+        {
+            ::munlock(m_begin, capacity());
+        }
+        ::munmap(m_begin, capacity());
+    }
+
+    inline void* HugePageResource::do_allocate(const std::size_t bytes, const std::size_t alignment)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const auto current = reinterpret_cast<std::uintptr_t>(m_current);
+            const auto aligned = (current + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+            if (aligned + bytes <= reinterpret_cast<std::uintptr_t>(m_end))
+            {
+                m_current = reinterpret_cast<std::byte*>(aligned + bytes);
+                return reinterpret_cast<void*>(aligned);
+            }
+        }
+        return m_upstream->allocate(bytes, alignment);
+    }
+
+    inline void HugePageResource::do_deallocate(void* const p, const std::size_t bytes, const std::size_t alignment)
+    {
+        const auto* const bytePtr = static_cast<const std::byte*>(p);
+        if (bytePtr < m_begin || bytePtr >= m_end)
+        {
+            m_upstream->deallocate(p, bytes, alignment);
+        }
+    }
+
+    inline bool HugePageResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+} // namespace mt
+
+#endif
@@ -0,0 +1,298 @@
+/**
+ * @file MergingConsumer.h
+ *
+ * @brief MergingConsumer class for consuming several ordered producer streams in global key order.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef MERGING_CONSUMER_H
+#define MERGING_CONSUMER_H
+
+#include "ProducerConsumerBase.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace mt
+{
+    // Merges one adapter per producer, each fed in non-decreasing key order, into a single stream
+    // in global key order using a loser tree, so every item costs O(log k) comparisons for k inputs.
+    // An input without a pending item holds the merge back until it delivers one, its watermark
+    // (last key seen or advanceWatermark) shows the other heads are safe, or it has been idle for
+    // idleTimeout. Items arriving below the last emitted key after that are emitted and counted as late.
+    template<typename Adapter, typename Callable, typename KeyOf>
+    class MergingConsumer : public ProducerConsumerBase<std::vector<std::reference_wrapper<Adapter>>>
+    {
+    public:
+        using Inputs = std::vector<std::reference_wrapper<Adapter>>;
+        using Elem = typename Adapter::Elem;
+        using Key = std::remove_cvref_t<std::invoke_result_t<KeyOf&, const Elem&>>;
+
+    private:
+        using Super = ProducerConsumerBase<Inputs>;
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr std::size_t ScanInterval = 64;
+
+        enum class Rank : unsigned char
+        {
+            Blocked,
+            Head,
+            Watermark,
+            Idle
+        };
+
+        struct Input
+        {
+            std::optional<Elem> head;
+            std::optional<Key> watermark;
+            Clock::time_point emptySince;
+        };
+
+        Callable m_callable;
+        KeyOf m_keyOf;
+        Clock::duration m_idleTimeout;
+        std::unique_ptr<std::atomic<Key>[]> m_advancedWatermarks;
+        std::unique_ptr<std::atomic<bool>[]> m_hasAdvancedWatermark;
+        std::atomic<std::size_t> m_lateItems{ 0 };
+
+        std::vector<Input> m_inputs;
+        std::vector<std::size_t> m_tree;
+        std::optional<Key> m_lastEmitted;
+
+    public:
+        explicit MergingConsumer(Inputs& inputs, Callable callable, KeyOf keyOf = KeyOf{},
+            Clock::duration idleTimeout = std::chrono::milliseconds(10));
+        MergingConsumer(const MergingConsumer&) = delete;
+        MergingConsumer(MergingConsumer&&) = delete;
+        MergingConsumer& operator=(const MergingConsumer&) = delete;
+        MergingConsumer& operator=(MergingConsumer&&) = delete;
+        ~MergingConsumer() override;
+
+        // Promise from producer input that it will not deliver keys below key any more.
+        void advanceWatermark(std::size_t input, Key key) noexcept;
+        [[nodiscard]] std::size_t lateItems() const noexcept;
+
+    private:
+        void workerThreadWork() override;
+        [[nodiscard]] bool refill(std::size_t input);
+        [[nodiscard]] Rank rank(std::size_t input, Clock::time_point now) const;
+        [[nodiscard]] bool before(std::size_t lhs, std::size_t rhs, Clock::time_point now) const;
+        void adjust(std::size_t input, Clock::time_point now);
+        void rebuild(Clock::time_point now);
+        void emit(std::size_t input);
+    };
+
+    template<typename Adapter, typename Callable, typename KeyOf>
+    MergingConsumer<Adapter, Callable, KeyOf>::MergingConsumer(Inputs& inputs, Callable callable, KeyOf keyOf,
+        const Clock::duration idleTimeout)
+        : Super(Super::Type::Consumer, inputs)
+        , m_callable(std::move(callable))
+        , m_keyOf(std::move(keyOf))
+        , m_idleTimeout(idleTimeout)
+        , m_advancedWatermarks(std::make_unique<std::atomic<Key>[]>(inputs.size()))
+        , m_hasAdvancedWatermark(std::make_unique<std::atomic<bool>[]>(inputs.size()))
+    {
+        static_assert(std::is_trivially_copyable_v<Key>, "Merge keys must be trivially copyable");
+        this->runMainThread();
+    }
+
+    template<typename Adapter, typename Callable, typename KeyOf>
+    MergingConsumer<Adapter, Callable, KeyOf>::~MergingConsumer()
+    {
+        this->shutdownMainThread();
+    }
+
+    template<typename Adapter, typename Callable, typename KeyOf>
+    void MergingConsumer<Adapter, Callable, KeyOf>::advanceWatermark(const std::size_t input, const Key key) noexcept
+    {
+        m_advancedWatermarks[input].store(key, std::memory_order_relaxed);
+        m_hasAdvancedWatermark[input].store(true, std::memory_order_release);
+    }
+
+    template<typename Adapter, typename Callable, typename KeyOf>
+    std::size_t MergingConsumer<Adapter, Callable, KeyOf>::lateItems() const noexcept
+    {
+        return m_lateItems.load(std::memory_order_relaxed);
+    }
+
+    template<typename Adapter, typename Callable, typename KeyOf>
+    void MergingConsumer<Adapter, Callable, KeyOf>::workerThreadWork()
+    {
+        const std::size_t count = this->m_sharedContainer.size();
+        if (m_inputs.size() != count)
+        {
+            m_inputs.assign(count, Input{ std::nullopt, std::nullopt, Clock::now() });
+        }
+        if (count == 0)
+        {
+            return;
+        }
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            static_cast<void>(refill(i));
+        }
+        rebuild(Clock::now());
+
+        std::size_t sinceScan = 0;
+        while (this->m_workerThreadEnabled)
+        {
+            const std::size_t winner = m_tree[0];
+            if (m_inputs[winner].head && ++sinceScan < ScanInterval)
+            {
+                emit(winner);
+                static_cast<void>(refill(winner));
+                adjust(winner, Clock::now());
+                this->onWork();
+                continue;
+            }
+
+            // Either the winner has nothing to deliver yet or it is time to look at idle inputs again.
+            sinceScan = 0;
+            bool arrived = false;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if (!m_inputs[i].head)
+                {
+                    arrived = refill(i) || arrived;
+                }
+            }
+            const Clock::time_point now = Clock::now();
+            rebuild(now);
+            if (!arrived && !m_inputs[m_tree[0]].head)
+            {
+                this->onIdle();
+            }
+        }
+    }
+
+    template<typename Adapter, typename Callable, typename KeyOf>
+    bool MergingConsumer<Adapter, Callable, KeyOf>::refill(const std::size_t input)
+    {
+        Input& state = m_inputs[input];
+        if (m_hasAdvancedWatermark[input].load(std::memory_order_acquire))
+        {
+            const Key advanced = m_advancedWatermarks[input].load(std::memory_order_relaxed);
+            if (!state.watermark || *state.watermark < advanced)
+            {
+                state.watermark = advanced;
+            }
+        }
+        if (Elem item; this->m_sharedContainer[input].get().tryPop(item))
+        {
+            state.head.emplace(std::move(item));
+            return true;
+        }
+        return false;
+    }
+
+    template<typename Adapter, typename Callable, typename KeyOf>
+    typename MergingConsumer<Adapter, Callable, KeyOf>::Rank
+        MergingConsumer<Adapter, Callable, KeyOf>::rank(const std::size_t input, const Clock::time_point now) const
+    {
+        const Input& state = m_inputs[input];
+        if (state.head)
+        {
+            return Rank::Head;
+        }
+        if (now - state.emptySince >= m_idleTimeout)
+        {
+            return Rank::Idle;
+        }
+        return state.watermark ? Rank::Watermark : Rank::Blocked;
+    }
+
+    // Order: blocked inputs first, then by key with heads ahead of equal watermarks, idle inputs last.
+    template<typename Adapter, typename Callable, typename KeyOf>
+    bool MergingConsumer<Adapter, Callable, KeyOf>::before(const std::size_t lhs, const std::size_t rhs, const Clock::time_point now) const
+    {
+        if (lhs == m_inputs.size() || rhs == m_inputs.size())
+        {
+            return lhs == m_inputs.size();
+        }
+        const Rank lhsRank = rank(lhs, now);
+        const Rank rhsRank = rank(rhs, now);
+        if (lhsRank == Rank::Blocked || rhsRank == Rank::Idle)
+        {
+            return rhsRank != Rank::Blocked;
+        }
+        if (rhsRank == Rank::Blocked || lhsRank == Rank::Idle)
+        {
+            return false;
+        }
+        const Key lhsKey = lhsRank == Rank::Head ? m_keyOf(*m_inputs[lhs].head) : *m_inputs[lhs].watermark;
+        const Key rhsKey = rhsRank == Rank::Head ? m_keyOf(*m_inputs[rhs].head) : *m_inputs[rhs].watermark;
+        if (lhsKey < rhsKey)
+        {
+            return true;
+        }
+        if (rhsKey < lhsKey)
+        {
+            return false;
+        }
+        return lhsRank == Rank::Head && rhsRank != Rank::Head;
+    }
+
+    template<typename Adapter, typename Callable, typename KeyOf>
+    void MergingConsumer<Adapter, Callable, KeyOf>::adjust(const std::size_t input, const Clock::time_point now)
+    {
+        const std::size_t count = m_inputs.size();
+        std::size_t winner = input;
+        for (std::size_t parent = (input + count) / 2; parent > 0; parent /= 2)
+        {
+            if (before(m_tree[parent], winner, now))
+            {
+                std::swap(m_tree[parent], winner);
+            }
+        }
+        m_tree[0] = winner;
+    }
+
+    template<typename Adapter, typename Callable, typename KeyOf>
+    void MergingConsumer<Adapter, Callable, KeyOf>::rebuild(const Clock::time_point now)
+    {
+        const std::size_t count = m_inputs.size();
+        // Index count is a virtual input that beats everything, so every leaf settles into place.
+        m_tree.assign(count, count);
+        for (std::size_t i = count; i-- > 0;)
+        {
+            adjust(i, now);
+        }
+    }
+
+    template<typename Adapter, typename Callable, typename KeyOf>
+    void MergingConsumer<Adapter, Callable, KeyOf>::emit(const std::size_t input)
+    {
+        Input& state = m_inputs[input];
+        const Key key = m_keyOf(*state.head);
+        if (m_lastEmitted && key < *m_lastEmitted)
+        {
+            m_lateItems.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            m_lastEmitted = key;
+        }
+        if (!state.watermark || *state.watermark < key)
+        {
+            state.watermark = key;
+        }
+        Elem item = std::move(*state.head);
+        state.head.reset();
+        m_callable(std::move_if_noexcept(item));
+        // Idleness counts from here: a head that waited long in the merge says nothing about
+        // how long the input has had nothing to deliver.
+        state.emptySince = Clock::now();
+    }
+} // namespace mt
+
+#endif
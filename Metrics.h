@@ -0,0 +1,379 @@
+/**
+ * @file Metrics.h
+ *
+ * @brief MetricsRegistry class for collecting counters of live adapters and workers in Prometheus text format.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mt
+{
+    // Lock-free histogram of durations in power-of-two nanosecond buckets, from 1us up to about 8.6s.
+    class LatencyHistogram
+    {
+    public:
+        static constexpr std::size_t FirstBucketShift = 10;
+        static constexpr std::size_t BucketCount = 24;
+
+    private:
+        std::array<std::atomic<std::uint64_t>, BucketCount + 1> m_buckets{};
+        std::atomic<std::uint64_t> m_sumNs{ 0 };
+
+    public:
+        LatencyHistogram() = default;
+        LatencyHistogram(const LatencyHistogram&) = delete;
+        LatencyHistogram(LatencyHistogram&&) = delete;
+        LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+        LatencyHistogram& operator=(LatencyHistogram&&) = delete;
+        ~LatencyHistogram() = default;
+
+        void record(const std::chrono::nanoseconds duration) noexcept
+        {
+            const auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(duration.count(), 0));
+            const std::size_t bucket = ns <= upperBoundNs(0) ? 0 : static_cast<std::size_t>(std::bit_width((ns - 1) >> FirstBucketShift));
+            m_buckets[std::min(bucket, BucketCount)].fetch_add(1, std::memory_order_relaxed);
+            m_sumNs.fetch_add(ns, std::memory_order_relaxed);
+        }
+
+        // Upper bound of bucket i in nanoseconds; the last bucket is unbounded.
+        [[nodiscard]] static constexpr std::uint64_t upperBoundNs(const std::size_t bucket) noexcept
+        {
+            return std::uint64_t{ 1 } << (FirstBucketShift + bucket);
+        }
+
+        [[nodiscard]] std::uint64_t bucket(const std::size_t i) const noexcept { return m_buckets[i].load(std::memory_order_relaxed); }
+        [[nodiscard]] std::uint64_t sumNs() const noexcept { return m_sumNs.load(std::memory_order_relaxed); }
+    };
+
+    // Groups samples by metric family, as the exposition format requires, and renders them.
+    class MetricsWriter
+    {
+    private:
+        struct Family
+        {
+            std::string_view help;
+            std::string_view type;
+            std::string samples;
+        };
+
+        std::map<std::string, Family, std::less<>> m_families;
+
+    public:
+        MetricsWriter() = default;
+        MetricsWriter(const MetricsWriter&) = delete;
+        MetricsWriter(MetricsWriter&&) = delete;
+        MetricsWriter& operator=(const MetricsWriter&) = delete;
+        MetricsWriter& operator=(MetricsWriter&&) = delete;
+        ~MetricsWriter() = default;
+
+        // labels is a preformatted label list such as adapter="orders"; see label().
+        void counter(std::string_view family, std::string_view help, std::string_view labels, double value);
+        void gauge(std::string_view family, std::string_view help, std::string_view labels, double value);
+        void histogram(std::string_view family, std::string_view help, std::string_view labels, const LatencyHistogram& histogram);
+
+        [[nodiscard]] std::string text() const;
+
+        [[nodiscard]] static std::string label(std::string_view name, std::string_view value);
+
+    private:
+        void sample(std::string_view family, std::string_view suffix, std::string_view help, std::string_view type,
+            std::string_view labels, double value);
+    };
+
+    class MetricsRegistry;
+
+    // Keeps a source registered while alive. It must be destroyed before the object it reports on;
+    // destruction waits for a collection in progress.
+    class MetricsRegistration
+    {
+    private:
+        MetricsRegistry* m_registry = nullptr;
+        std::uint64_t m_id = 0;
+
+    public:
+        MetricsRegistration() = default;
+        MetricsRegistration(MetricsRegistry& registry, std::uint64_t id) noexcept;
+        MetricsRegistration(const MetricsRegistration&) = delete;
+        MetricsRegistration(MetricsRegistration&& rhs) noexcept;
+        MetricsRegistration& operator=(const MetricsRegistration&) = delete;
+        MetricsRegistration& operator=(MetricsRegistration&& rhs) noexcept;
+        ~MetricsRegistration();
+
+        void reset();
+    };
+
+    // Sources only read atomics, so collecting never takes a lock on the adapters or workers.
+    class MetricsRegistry
+    {
+    private:
+        struct Source
+        {
+            std::uint64_t id;
+            std::function<void(MetricsWriter&)> collect;
+        };
+
+        mutable std::mutex m_mutex;
+        std::vector<Source> m_sources;
+        std::uint64_t m_nextId = 1;
+
+    public:
+        MetricsRegistry() = default;
+        MetricsRegistry(const MetricsRegistry&) = delete;
+        MetricsRegistry(MetricsRegistry&&) = delete;
+        MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+        MetricsRegistry& operator=(MetricsRegistry&&) = delete;
+        ~MetricsRegistry() = default;
+
+        static MetricsRegistry& shared();
+
+        [[nodiscard]] MetricsRegistration add(std::function<void(MetricsWriter&)> collect);
+
+        template<typename Adapter>
+        [[nodiscard]] MetricsRegistration addAdapter(std::string name, const Adapter& adapter);
+
+        template<typename Worker>
+        [[nodiscard]] MetricsRegistration addWorker(std::string name, const Worker& worker);
+
+        [[nodiscard]] MetricsRegistration addHistogram(std::string name, const LatencyHistogram& histogram);
+
+        [[nodiscard]] std::string collect() const;
+
+    private:
+        friend class MetricsRegistration;
+        void remove(std::uint64_t id);
+    };
+
+    inline void MetricsWriter::counter(const std::string_view family, const std::string_view help, const std::string_view labels, const double value)
+    {
+        sample(family, "", help, "counter", labels, value);
+    }
+
+    inline void MetricsWriter::gauge(const std::string_view family, const std::string_view help, const std::string_view labels, const double value)
+    {
+        sample(family, "", help, "gauge", labels, value);
+    }
+
+    inline void MetricsWriter::histogram(const std::string_view family, const std::string_view help, const std::string_view labels,
+        const LatencyHistogram& histogram)
+    {
+        const std::string separator = labels.empty() ? "" : std::string(labels) + ",";
+        std::uint64_t cumulative = 0;
+        for (std::size_t i = 0; i < LatencyHistogram::BucketCount; ++i)
+        {
+            cumulative += histogram.bucket(i);
+            std::ostringstream bound;
+            bound.precision(12);
+            bound << static_cast<double>(LatencyHistogram::upperBoundNs(i)) / 1e9;
+            sample(family, "_bucket", help, "histogram", separator + label("le", bound.str()), static_cast<double>(cumulative));
+        }
+        cumulative += histogram.bucket(LatencyHistogram::BucketCount);
+        sample(family, "_bucket", help, "histogram", separator + label("le", "+Inf"), static_cast<double>(cumulative));
+        sample(family, "_sum", help, "histogram", labels, static_cast<double>(histogram.sumNs()) / 1e9);
+        sample(family, "_count", help, "histogram", labels, static_cast<double>(cumulative));
+    }
+
+    inline void MetricsWriter::sample(const std::string_view family, const std::string_view suffix, const std::string_view help,
+        const std::string_view type, const std::string_view labels, const double value)
+    {
+        auto it = m_families.find(family);
+        if (it == m_families.end())
+        {
+            it = m_families.emplace(std::string(family), Family{ help, type, {} }).first;
+        }
+        std::ostringstream line;
+        line.precision(17);
+        line << family << suffix;
+        if (!labels.empty())
+        {
+            line << '{' << labels << '}';
+        }
+        line << ' ' << value << '\n';
+        it->second.samples += line.str();
+    }
+
+    inline std::string MetricsWriter::text() const
+    {
+        std::string text;
+        for (const auto& [name, family] : m_families)
+        {
+            text.append("# HELP ").append(name).append(" ").append(family.help).append("\n");
+            text.append("# TYPE ").append(name).append(" ").append(family.type).append("\n");
+            text.append(family.samples);
+        }
+        return text;
+    }
+
+    inline std::string MetricsWriter::label(const std::string_view name, const std::string_view value)
+    {
+        std::string label(name);
+        label += "=\"";
+        for (const char c : value)
+        {
+            if (c == '\\' || c == '"')
+            {
+                label += '\\';
+                label += c;
+            }
+            else if (c == '\n')
+            {
+                label += "\\n";
+            }
+            else
+            {
+                label += c;
+            }
+        }
+        label += '"';
+        return label;
+    }
+
+    inline MetricsRegistration::MetricsRegistration(MetricsRegistry& registry, const std::uint64_t id) noexcept
+        : m_registry(&registry)
+        , m_id(id)
+    {
+    }
+
+    inline MetricsRegistration::MetricsRegistration(MetricsRegistration&& rhs) noexcept
+        : m_registry(std::exchange(rhs.m_registry, nullptr))
+        , m_id(std::exchange(rhs.m_id, 0))
+    {
+    }
+
+    inline MetricsRegistration& MetricsRegistration::operator=(MetricsRegistration&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            reset();
+            m_registry = std::exchange(rhs.m_registry, nullptr);
+            m_id = std::exchange(rhs.m_id, 0);
+        }
+        return *this;
+    }
+
+    inline MetricsRegistration::~MetricsRegistration()
+    {
+        reset();
+    }
+
+    inline void MetricsRegistration::reset()
+    {
+        if (m_registry)
+        {
+            std::exchange(m_registry, nullptr)->remove(m_id);
+        }
+    }
+
+    inline MetricsRegistry& MetricsRegistry::shared()
+    {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    inline MetricsRegistration MetricsRegistry::add(std::function<void(MetricsWriter&)> collect)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const std::uint64_t id = m_nextId++;
+        m_sources.push_back(Source{ id, std::move(collect) });
+        return MetricsRegistration(*this, id);
+    }
+
+    template<typename Adapter>
+    MetricsRegistration MetricsRegistry::addAdapter(std::string name, const Adapter& adapter)
+    {
+        return add([labels = MetricsWriter::label("adapter", name), &adapter](MetricsWriter& writer)
+            {
+                writer.gauge("mt_adapter_size", "Elements held by the adapter.", labels, static_cast<double>(adapter.sizeApprox()));
+                if constexpr (requires { adapter.highWaterMark(); })
+                {
+                    writer.gauge("mt_adapter_high_water_mark", "Largest size since the last reset.", labels,
+                        static_cast<double>(adapter.highWaterMark()));
+                }
+                if constexpr (requires { adapter.enqueuedCount(); adapter.dequeuedCount(); })
+                {
+                    writer.counter("mt_adapter_enqueued_total", "Elements added to the adapter.", labels, static_cast<double>(adapter.enqueuedCount()));
+                    writer.counter("mt_adapter_dequeued_total", "Elements removed from the adapter.", labels, static_cast<double>(adapter.dequeuedCount()));
+                }
+                if constexpr (requires { adapter.expiredCount(); })
+                {
+                    writer.counter("mt_adapter_expired_total", "Elements dropped after their deadline.", labels, static_cast<double>(adapter.expiredCount()));
+                }
+            });
+    }
+
+    template<typename Worker>
+    MetricsRegistration MetricsRegistry::addWorker(std::string name, const Worker& worker)
+    {
+        return add([labels = MetricsWriter::label("worker", name), &worker](MetricsWriter& writer)
+            {
+                writer.counter("mt_worker_heartbeats_total", "Worker loop iterations.", labels, static_cast<double>(worker.heartbeats()));
+                writer.gauge("mt_worker_enabled", "Whether the worker thread is enabled.", labels, worker.workerThreadEnabled() ? 1.0 : 0.0);
+                if constexpr (requires { worker.deadlineStats(); })
+                {
+                    const auto stats = worker.deadlineStats();
+                    const auto outcome = [&](const std::string_view value) { return labels + "," + MetricsWriter::label("outcome", value); };
+                    const std::string_view help = "Expiring elements by deadline outcome.";
+                    writer.counter("mt_consumer_deadlines_total", help, outcome("met"), static_cast<double>(stats.met));
+                    writer.counter("mt_consumer_deadlines_total", help, outcome("missed"), static_cast<double>(stats.missed));
+                    writer.counter("mt_consumer_deadlines_total", help, outcome("shed"), static_cast<double>(stats.shed));
+                }
+                if constexpr (requires { worker.quotaStats(); })
+                {
+                    const auto stats = worker.quotaStats();
+                    const auto action = [&](const std::string_view value) { return labels + "," + MetricsWriter::label("action", value); };
+                    const std::string_view help = "Elements adjusted or dropped by the producer quota.";
+                    writer.counter("mt_producer_quota_total", help, action("capped"), static_cast<double>(stats.capped));
+                    writer.counter("mt_producer_quota_total", help, action("demoted"), static_cast<double>(stats.demoted));
+                    writer.counter("mt_producer_quota_total", help, action("rejected"), static_cast<double>(stats.rejected));
+                }
+            });
+    }
+
+    inline MetricsRegistration MetricsRegistry::addHistogram(std::string name, const LatencyHistogram& histogram)
+    {
+        return add([labels = MetricsWriter::label("name", name), &histogram](MetricsWriter& writer)
+            {
+                writer.histogram("mt_latency_seconds", "Recorded durations.", labels, histogram);
+            });
+    }
+
+    inline std::string MetricsRegistry::collect() const
+    {
+        MetricsWriter writer;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const Source& source : m_sources)
+        {
+            source.collect(writer);
+        }
+        return writer.text();
+    }
+
+    inline void MetricsRegistry::remove(const std::uint64_t id)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::erase_if(m_sources, [id](const Source& source) { return source.id == id; });
+    }
+} // namespace mt
+
+#endif
@@ -0,0 +1,249 @@
+/**
+ * @file MetricsExporter.h
+ *
+ * @brief MetricsExporter class for publishing a MetricsRegistry to a file or a local Unix socket.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include "Metrics.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace mt
+{
+    struct MetricsSocketFailed : std::exception
+    {
+        [[nodiscard]] const char* what() const noexcept override { return "Exception: Failed to listen on the metrics socket"; }
+    };
+
+    // With file set, the exposition text is rewritten every period through a temporary file and a
+    // rename, so readers such as the node exporter textfile collector never see a partial file.
+    // With socket set, every connection gets the current text as an HTTP/1.0 response, so it can
+    // be scraped with curl --unix-socket or a forwarding proxy. Either may be left empty.
+    struct MetricsExportOptions
+    {
+        std::filesystem::path file;
+        std::filesystem::path socket;
+        std::chrono::milliseconds period{ 1000 };
+    };
+
+    class MetricsExporter
+    {
+    private:
+        static constexpr std::string_view Name = "METRICS";
+        static constexpr std::chrono::milliseconds SendTimeout{ 1000 };
+
+        MetricsRegistry& m_registry;
+        MetricsExportOptions m_options;
+        int m_wakeFd = -1;
+        int m_listenFd = -1;
+        std::jthread m_thread;
+
+    public:
+        explicit MetricsExporter(MetricsExportOptions options, MetricsRegistry& registry = MetricsRegistry::shared());
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter(MetricsExporter&&) = delete;
+        MetricsExporter& operator=(const MetricsExporter&) = delete;
+        MetricsExporter& operator=(MetricsExporter&&) = delete;
+        ~MetricsExporter();
+
+    private:
+        void exporterThreadWork(std::stop_token stopToken);
+        void writeFile();
+        void serveConnection();
+        void closeDescriptors() noexcept;
+    };
+
+    inline MetricsExporter::MetricsExporter(MetricsExportOptions options, MetricsRegistry& registry)
+        : m_registry(registry)
+        , m_options(std::move(options))
+    {
+        m_wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (m_wakeFd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "eventfd");
+        }
+        if (!m_options.socket.empty())
+        {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            const std::string path = m_options.socket.string();
+            m_listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (path.size() >= sizeof(address.sun_path) || m_listenFd < 0)
+            {
+                closeDescriptors();
+                throw MetricsSocketFailed{};
+            }
+            std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+            ::unlink(path.c_str());
+            if (::bind(m_listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(m_listenFd, 16) != 0)
+            {
+                closeDescriptors();
+                throw MetricsSocketFailed{};
+            }
+        }
+        m_thread = std::jthread([this](const std::stop_token stopToken) { exporterThreadWork(stopToken); });
+    }
+
+    inline MetricsExporter::~MetricsExporter()
+    {
+        m_thread.request_stop();
+        m_thread.join();
+        closeDescriptors();
+        if (!m_options.socket.empty())
+        {
+            ::unlink(m_options.socket.c_str());
+        }
+    }
+
+    inline void MetricsExporter::closeDescriptors() noexcept
+    {
+        for (int* const fd : { &m_wakeFd, &m_listenFd })
+        {
+            if (*fd >= 0)
+            {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+    }
+
+    inline void MetricsExporter::exporterThreadWork(const std::stop_token stopToken)
+    {
+        const std::stop_callback wake(stopToken, [this]
+            {
+                const std::uint64_t one = 1;
+                static_cast<void>(::write(m_wakeFd, &one, sizeof(one)));
+            });
+        auto nextWrite = std::chrono::steady_clock::now();
+        while (!stopToken.stop_requested())
+        {
+            try
+            {
+                int timeout = -1;
+                if (!m_options.file.empty())
+                {
+                    if (std::chrono::steady_clock::now() >= nextWrite)
+                    {
+                        // Advanced first, so that a failing write is retried next period rather
+                        // than in a tight loop.
+                        nextWrite = std::chrono::steady_clock::now() + m_options.period;
+                        writeFile();
+                    }
+                    timeout = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(nextWrite - std::chrono::steady_clock::now()).count());
+                }
+                pollfd fds[2] = { { m_wakeFd, POLLIN, 0 }, { m_listenFd, POLLIN, 0 } };
+                if (::poll(fds, m_listenFd < 0 ? 1 : 2, timeout) > 0 && (fds[1].revents & POLLIN) != 0)
+                {
+                    serveConnection();
+                }
+            }
+            catch (const std::exception& ex)
+            {
+                std::cerr << Name << " -> " << ex.what() << std::endl;
+            }
+            catch (...)
+            {
+                std::cerr << Name << " -> Unknown exception" << std::endl;
+            }
+        }
+    }
+
+    inline void MetricsExporter::writeFile()
+    {
+        std::filesystem::path temporary = m_options.file;
+        temporary += ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::trunc);
+            out << m_registry.collect();
+            if (!out.flush())
+            {
+                std::cerr << Name << " -> Failed to write " << temporary << std::endl;
+                return;
+            }
+        }
+        std::filesystem::rename(temporary, m_options.file);
+    }
+
+    // Reads whatever request arrives within a short grace period, so that closing does not reset
+    // the connection under the client, then answers with the current text. The socket is
+    // non-blocking and a client that does not take the response within SendTimeout is dropped,
+    // so a slow reader cannot stall the periodic file writes.
+    inline void MetricsExporter::serveConnection()
+    {
+        const int fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (fd < 0)
+        {
+            return;
+        }
+        std::string request;
+        char buffer[1024];
+        pollfd client{ fd, POLLIN, 0 };
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192 && ::poll(&client, 1, 100) > 0)
+        {
+            const ssize_t count = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (count <= 0)
+            {
+                break;
+            }
+            request.append(buffer, static_cast<std::size_t>(count));
+        }
+
+        const std::string body = m_registry.collect();
+        const std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+            + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        const auto deadline = std::chrono::steady_clock::now() + SendTimeout;
+        for (std::size_t sent = 0; sent < response.size();)
+        {
+            const ssize_t count = ::send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (count > 0)
+            {
+                sent += static_cast<std::size_t>(count);
+                continue;
+            }
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+            {
+                break;
+            }
+            const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            pollfd writable{ fd, POLLOUT, 0 };
+            if (remaining <= 0 || ::poll(&writable, 1, static_cast<int>(remaining)) <= 0)
+            {
+                std::cerr << Name << " -> Dropped a client that did not read the response in time" << std::endl;
+                break;
+            }
+        }
+        ::close(fd);
+    }
+} // namespace mt
+
+#endif
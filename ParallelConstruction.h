@@ -0,0 +1,195 @@
+/**
+ * @file ParallelConstruction.h
+ *
+ * @brief Parallel bulk construction of ThreadSafeSTLAdapter from pre-filled STL adapters.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef PARALLEL_CONSTRUCTION_H
+#define PARALLEL_CONSTRUCTION_H
+
+#include "ThreadSafeSTLAdapter.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <execution>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mt
+{
+    // With libstdc++ the parallel execution policies run on TBB, so programs that include this
+    // header must link with -ltbb.
+
+    // Storage for up to capacity elements constructed in place. Elements alias the chunk's
+    // ownership, so a chunk is released once the last of its elements has been popped.
+    template<typename Elem, typename Allocator>
+    class BulkChunk
+    {
+    private:
+        using Traits = std::allocator_traits<Allocator>;
+
+        Allocator m_allocator;
+        Elem* m_items;
+        std::size_t m_capacity;
+        std::size_t m_size = 0;
+
+    public:
+        BulkChunk(const Allocator& allocator, std::size_t capacity);
+        BulkChunk(const BulkChunk&) = delete;
+        BulkChunk(BulkChunk&&) = delete;
+        BulkChunk& operator=(const BulkChunk&) = delete;
+        BulkChunk& operator=(BulkChunk&&) = delete;
+        ~BulkChunk();
+
+        template<typename... Args>
+        Elem& emplace(Args&&... args);
+    };
+
+    template<typename Elem, typename Allocator>
+    BulkChunk<Elem, Allocator>::BulkChunk(const Allocator& allocator, const std::size_t capacity)
+        : m_allocator(allocator)
+        , m_items(Traits::allocate(m_allocator, capacity))
+        , m_capacity(capacity)
+    { }
+
+    template<typename Elem, typename Allocator>
+    BulkChunk<Elem, Allocator>::~BulkChunk()
+    {
+        while (m_size != 0)
+        {
+            Traits::destroy(m_allocator, m_items + --m_size);
+        }
+        Traits::deallocate(m_allocator, m_items, m_capacity);
+    }
+
+    template<typename Elem, typename Allocator>
+    template<typename... Args>
+    Elem& BulkChunk<Elem, Allocator>::emplace(Args&&... args)
+    {
+        Traits::construct(m_allocator, m_items + m_size, std::forward<Args>(args)...);
+        return m_items[m_size++];
+    }
+
+    // Allocation and element constructors may take locks, which unsequenced policies forbid, so
+    // those run with their sequenced counterparts.
+    template<typename ExecutionPolicy>
+    [[nodiscard]] auto sequencedPolicy(ExecutionPolicy&& policy)
+    {
+        using Policy = std::remove_cvref_t<ExecutionPolicy>;
+        if constexpr (std::is_same_v<Policy, std::execution::parallel_unsequenced_policy>)
+        {
+            return std::execution::par;
+        }
+        else if constexpr (std::is_same_v<Policy, std::execution::unsequenced_policy>)
+        {
+            return std::execution::seq;
+        }
+        else
+        {
+            return Policy(std::forward<ExecutionPolicy>(policy));
+        }
+    }
+
+    inline constexpr std::size_t BulkChunkSize = 1024;
+
+    // Converts all elements with the given execution policy. The storage is allocated up front,
+    // one block per BulkChunkSize elements, and each worker then constructs the elements of whole
+    // chunks in place, so no worker allocates or shares a reference count with another. A held
+    // element keeps at most its own chunk alive.
+    template<typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename ExecutionPolicy, typename Container>
+    [[nodiscard]] Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>> bulkConvertToSharedPtrContainer(ExecutionPolicy&& policy, Container& container)
+    {
+        using SourceItem = std::conditional_t<std::is_const_v<Container>, const AdaptElem&, AdaptElem&&>;
+        using Chunk = BulkChunk<AdaptElem, Alloc<AdaptElem>>;
+        const Alloc<std::shared_ptr<AllocElem>> allocator(container.get_allocator());
+        const std::size_t size = container.size();
+        Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>> result(size, allocator);
+
+        std::vector<std::shared_ptr<Chunk>> chunks;
+        chunks.reserve((size + BulkChunkSize - 1) / BulkChunkSize);
+        for (std::size_t begin = 0; begin < size; begin += BulkChunkSize)
+        {
+            chunks.push_back(std::allocate_shared<Chunk>(Alloc<Chunk>(allocator), Alloc<AdaptElem>(allocator), std::min(BulkChunkSize, size - begin)));
+        }
+        const auto sequenced = sequencedPolicy(std::forward<ExecutionPolicy>(policy));
+        std::for_each(sequenced, chunks.begin(), chunks.end(),
+            [&](const std::shared_ptr<Chunk>& chunk)
+            {
+                const auto begin = static_cast<std::size_t>(&chunk - chunks.data()) * BulkChunkSize;
+                const std::size_t end = std::min(begin + BulkChunkSize, size);
+                auto source = std::next(container.begin(), static_cast<std::ptrdiff_t>(begin));
+                auto target = std::next(result.begin(), static_cast<std::ptrdiff_t>(begin));
+                for (std::size_t i = begin; i < end; ++i, ++source, ++target)
+                {
+                    *target = std::shared_ptr<AdaptElem>(chunk, &chunk->emplace(static_cast<SourceItem>(*source)));
+                }
+            });
+        return result;
+    }
+
+    template<typename ExecutionPolicy, template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    [[nodiscard]] auto createThreadSafeSTLAdapterFrom(ExecutionPolicy&& policy, const Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>& adapter, Ts... comparator)
+    {
+        static_assert(std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>);
+        auto& underlyingContainer = getProtectedContainer(adapter);
+        auto underlyingSharedPtrContainer = bulkConvertToSharedPtrContainer<AdaptElem, Cont, ContElem, Alloc, AllocElem>(
+            std::forward<ExecutionPolicy>(policy), underlyingContainer);
+        if constexpr (sizeof...(Ts) == 1)
+        {
+            // std::priority_queue
+            Adapt<std::shared_ptr<AdaptElem>, Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>>, CustomComparator<Ts...>>
+                adapterWithSharedPtrElements(CustomComparator{ std::move(comparator...) }, underlyingSharedPtrContainer.get_allocator());
+            getProtectedContainer(adapterWithSharedPtrElements) = std::move(underlyingSharedPtrContainer);
+            return ThreadSafeSTLAdapter{ std::move(adapterWithSharedPtrElements) };
+        }
+        if constexpr (sizeof...(Ts) == 0)
+        {
+            // std::stack / std::queue
+            Adapt<std::shared_ptr<AdaptElem>, Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>>>
+                adapterWithSharedPtrElements(std::move(underlyingSharedPtrContainer));
+            return ThreadSafeSTLAdapter{ std::move(adapterWithSharedPtrElements) };
+        }
+    }
+
+    template<typename ExecutionPolicy, template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    [[nodiscard]] auto createThreadSafeSTLAdapterFrom(ExecutionPolicy&& policy, Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>&& adapter, Ts... comparator)
+    {
+        static_assert(std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>);
+        auto& underlyingContainer = getProtectedContainer(adapter);
+        auto underlyingSharedPtrContainer = bulkConvertToSharedPtrContainer<AdaptElem, Cont, ContElem, Alloc, AllocElem>(
+            std::forward<ExecutionPolicy>(policy), underlyingContainer);
+        if constexpr (sizeof...(Ts) == 1)
+        {
+            // std::priority_queue
+            Adapt<std::shared_ptr<AdaptElem>, Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>>, CustomComparator<Ts...>>
+                adapterWithSharedPtrElements(CustomComparator{ std::move(comparator...) }, underlyingSharedPtrContainer.get_allocator());
+            getProtectedContainer(adapterWithSharedPtrElements) = std::move(underlyingSharedPtrContainer);
+            return ThreadSafeSTLAdapter{ std::move(adapterWithSharedPtrElements) };
+        }
+        if constexpr (sizeof...(Ts) == 0)
+        {
+            // std::stack / std::queue
+            Adapt<std::shared_ptr<AdaptElem>, Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>>>
+                adapterWithSharedPtrElements(std::move(underlyingSharedPtrContainer));
+            return ThreadSafeSTLAdapter{ std::move(adapterWithSharedPtrElements) };
+        }
+    }
+} // namespace mt
+
+#endif
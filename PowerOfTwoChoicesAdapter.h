@@ -0,0 +1,115 @@
+/**
+ * @file PowerOfTwoChoicesAdapter.h
+ *
+ * @brief PowerOfTwoChoicesAdapter class for balancing pushes across per-consumer adapters.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef POWER_OF_TWO_CHOICES_ADAPTER_H
+#define POWER_OF_TWO_CHOICES_ADAPTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace mt
+{
+    struct NoAdapters : std::exception
+    {
+        [[nodiscard]] const char* what() const noexcept override { return "Exception: At least one adapter is required"; }
+    };
+
+    // Push-only front for N adapters, each typically drained by its own Consumer. Every element
+    // goes to the shorter of two randomly chosen adapters, judged by their lock-free sizeApprox,
+    // so pushes never meet on a central lock. Pass it to Producer like any shared container.
+    template<typename Adapter>
+    class PowerOfTwoChoicesAdapter
+    {
+    public:
+        using Elem = typename Adapter::Elem;
+
+    private:
+        std::vector<std::reference_wrapper<Adapter>> m_adapters;
+
+    public:
+        explicit PowerOfTwoChoicesAdapter(std::vector<std::reference_wrapper<Adapter>> adapters);
+        PowerOfTwoChoicesAdapter(const PowerOfTwoChoicesAdapter&) = default;
+        PowerOfTwoChoicesAdapter(PowerOfTwoChoicesAdapter&&) = default;
+        PowerOfTwoChoicesAdapter& operator=(const PowerOfTwoChoicesAdapter&) = default;
+        PowerOfTwoChoicesAdapter& operator=(PowerOfTwoChoicesAdapter&&) = default;
+        ~PowerOfTwoChoicesAdapter() = default;
+
+        void push(Elem value);
+        void pushAndNotify(Elem value);
+
+        [[nodiscard]] std::size_t sizeApprox() const noexcept;
+        [[nodiscard]] bool emptyApprox() const noexcept;
+
+    private:
+        [[nodiscard]] Adapter& choose() const noexcept;
+    };
+
+    template<typename Adapter>
+    PowerOfTwoChoicesAdapter<Adapter>::PowerOfTwoChoicesAdapter(std::vector<std::reference_wrapper<Adapter>> adapters)
+        : m_adapters(std::move(adapters))
+    {
+        if (m_adapters.empty())
+        {
+            throw NoAdapters{};
+        }
+    }
+
+    template<typename Adapter>
+    void PowerOfTwoChoicesAdapter<Adapter>::push(Elem value)
+    {
+        choose().push(std::move_if_noexcept(value));
+    }
+
+    template<typename Adapter>
+    void PowerOfTwoChoicesAdapter<Adapter>::pushAndNotify(Elem value)
+    {
+        choose().pushAndNotify(std::move_if_noexcept(value));
+    }
+
+    template<typename Adapter>
+    std::size_t PowerOfTwoChoicesAdapter<Adapter>::sizeApprox() const noexcept
+    {
+        return std::accumulate(m_adapters.cbegin(), m_adapters.cend(), std::size_t{ 0 },
+            [](const std::size_t sum, const Adapter& adapter) { return sum + adapter.sizeApprox(); });
+    }
+
+    template<typename Adapter>
+    bool PowerOfTwoChoicesAdapter<Adapter>::emptyApprox() const noexcept
+    {
+        return sizeApprox() == 0;
+    }
+
+    template<typename Adapter>
+    Adapter& PowerOfTwoChoicesAdapter<Adapter>::choose() const noexcept
+    {
+        const std::size_t count = m_adapters.size();
+        if (count == 1)
+        {
+            return m_adapters.front();
+        }
+        thread_local std::uint64_t state = 0x9E3779B97F4A7C15ull ^ reinterpret_cast<std::uintptr_t>(&state);
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        const std::size_t first = static_cast<std::size_t>(state % count);
+        const std::size_t second = (first + 1 + static_cast<std::size_t>((state >> 32) % (count - 1))) % count;
+        Adapter& lhs = m_adapters[first];
+        Adapter& rhs = m_adapters[second];
+        return rhs.sizeApprox() < lhs.sizeApprox() ? rhs : lhs;
+    }
+} // namespace mt
+
+#endif
@@ -13,6 +13,9 @@
 #define PRODUCER_H
 
 #include "ProducerConsumerBase.h"
+#include "ProducerQuota.h"
+#include "PushTrace.h"
+#include "Reply.h"
 
 namespace mt
 {
@@ -23,6 +26,13 @@ namespace mt
         using Super = ProducerConsumerBase<Adapter>;
         using Elem = typename Adapter::Elem;
         decltype(createThreadSafeSTLAdapterFrom(std::queue<std::vector<Elem>>{})) m_vectorItemsQueue;
+        std::shared_ptr<void> m_replyPool;
+        std::atomic<PushTraceRecorder*> m_pushTrace{ nullptr };
+        QuotaOptions m_quotaOptions;
+        ProducerQuota m_quota;
+        std::chrono::steady_clock::duration m_purgeInterval{ std::chrono::milliseconds(100) };
+        std::chrono::steady_clock::duration m_workerPurgeInterval{ 0 };
+        std::chrono::steady_clock::time_point m_nextPurge;
 
     public:
         explicit Producer(Adapter& sharedContainer);
@@ -34,8 +44,22 @@ namespace mt
 
         void push(std::vector<Elem> items);
 
+        // Records every following push into recorder, which must outlive the recording; nullptr stops it.
+        void setPushTrace(PushTraceRecorder* recorder) noexcept;
+
+        void setQuota(const QuotaOptions& options);
+        [[nodiscard]] QuotaStats quotaStats() const noexcept;
+
+        void setPurgeInterval(std::chrono::steady_clock::duration interval);
+
+        template<typename E = Elem>
+            requires IsRequest<E>::value
+        Reply<typename E::Result> pushWithReply(typename E::Value value);
+
     private:
         void workerThreadWork() override;
+        void prepareWorkerThread() override;
+        void purgeExpiredPeriodically();
     };
 
     template<typename Adapter>
@@ -43,6 +67,10 @@ namespace mt
         : Super(Super::Type::Producer, sharedContainer)
         , m_vectorItemsQueue(createThreadSafeSTLAdapterFrom(std::queue<std::vector<Elem>>{}))
     {
+        if constexpr (IsRequest<Elem>::value)
+        {
+            m_replyPool = std::make_shared<ReplyPool<typename Elem::Result>>();
+        }
         this->runMainThread();
     }
 
@@ -55,9 +83,95 @@ namespace mt
     template<typename Adapter>
     void Producer<Adapter>::push(std::vector<Elem> items)
     {
+        TraceScope scope("Producer::push");
+        if (PushTraceRecorder* const recorder = m_pushTrace.load(std::memory_order_acquire))
+        {
+            recorder->record(items);
+        }
         m_vectorItemsQueue.push(std::move(items));
     }
 
+    template<typename Adapter>
+    void Producer<Adapter>::setPushTrace(PushTraceRecorder* const recorder) noexcept
+    {
+        m_pushTrace.store(recorder, std::memory_order_release);
+    }
+
+    // Takes effect the next time the worker thread is enabled, with a full token bucket.
+    template<typename Adapter>
+    void Producer<Adapter>::setQuota(const QuotaOptions& options)
+    {
+        std::lock_guard<std::mutex> lock(this->m_workerThreadMutex);
+        m_quotaOptions = options;
+    }
+
+    template<typename Adapter>
+    QuotaStats Producer<Adapter>::quotaStats() const noexcept
+    {
+        return m_quota.stats();
+    }
+
+    // Expired elements are otherwise dropped only when a consumer dequeues, so while none is
+    // draining the adapter the worker purges them every interval; zero disables it. Takes effect
+    // the next time the worker thread is enabled.
+    template<typename Adapter>
+    void Producer<Adapter>::setPurgeInterval(const std::chrono::steady_clock::duration interval)
+    {
+        std::lock_guard<std::mutex> lock(this->m_workerThreadMutex);
+        m_purgeInterval = interval;
+    }
+
+    template<typename Adapter>
+    void Producer<Adapter>::prepareWorkerThread()
+    {
+        m_quota.setOptions(m_quotaOptions);
+        m_workerPurgeInterval = m_purgeInterval;
+        m_nextPurge = std::chrono::steady_clock::now() + m_workerPurgeInterval;
+    }
+
+    template<typename Adapter>
+    void Producer<Adapter>::purgeExpiredPeriodically()
+    {
+        if constexpr (IsExpiring<Elem>::value && requires { this->m_sharedContainer.purgeExpired(); })
+        {
+            if (m_workerPurgeInterval == std::chrono::steady_clock::duration::zero())
+            {
+                return;
+            }
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= m_nextPurge)
+            {
+                m_nextPurge = now + m_workerPurgeInterval;
+                static_cast<void>(this->m_sharedContainer.purgeExpired());
+            }
+        }
+    }
+
+    // Waits for a free reply slot when all of them are outstanding, which bounds in-flight requests.
+    // The reply slot is pooled, but the request still travels like any other push: it costs the
+    // one-element batch, its node in the producer's queue, and its shared_ptr node in the shared
+    // adapter (plus the adapter's temporary in pushBatch). Only the last comes from the adapter's
+    // allocator, so a std::pmr pool resource there recycles it.
+    template<typename Adapter>
+    template<typename E>
+        requires IsRequest<E>::value
+    Reply<typename E::Result> Producer<Adapter>::pushWithReply(typename E::Value value)
+    {
+        using Result = typename E::Result;
+        auto pool = std::static_pointer_cast<ReplyPool<Result>>(m_replyPool);
+        ReplySlot<Result>* slot = pool->tryAcquire();
+        while (!slot)
+        {
+            std::this_thread::yield();
+            slot = pool->tryAcquire();
+        }
+        Reply<Result> reply(pool, slot);
+        std::vector<Elem> items;
+        items.emplace_back(std::move(value), std::move(pool), slot);
+        push(std::move(items));
+        return reply;
+    }
+
     template<typename Adapter>
     void Producer<Adapter>::workerThreadWork()
     {
@@ -66,14 +180,16 @@ namespace mt
             std::vector<Elem> vectorItem;
             if (m_vectorItemsQueue.tryPop(vectorItem))
             {
-                for (auto& item : vectorItem)
-                {
-                    this->m_sharedContainer.push(std::move(item));
-                }
+                TraceScope scope("Producer::transfer");
+                m_quota.apply(vectorItem);
+                pushItems(this->m_sharedContainer, vectorItem);
+                purgeExpiredPeriodically();
+                this->onWork();
             }
             else
             {
-                std::this_thread::yield();
+                purgeExpiredPeriodically();
+                this->onIdle();
             }
         }
     }
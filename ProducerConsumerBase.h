@@ -14,11 +14,65 @@
 
 #include "ThreadSafeSTLAdapter.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
 #include <iostream>
 #include <queue>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
 
 namespace mt
 {
+    struct InvalidCpu : std::exception
+    {
+        [[nodiscard]] const char* what() const noexcept override { return "Exception: The CPU index is outside the range of cpu_set_t"; }
+    };
+
+    struct RealTimeOptions
+    {
+        bool enabled = false;
+        int priority = 80;
+        int cpu = -1;
+        bool lockMemory = true;
+        // The watchdog forces the worker to sleep for backoff once it has been spinning
+        // or running without a break for watchdogPeriod, so that it cannot starve the system.
+        std::chrono::microseconds watchdogPeriod{ 100'000 };
+        std::chrono::microseconds backoff{ 100 };
+    };
+
+    inline void cpuRelax() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    // Takes a single lock for the whole batch when the adapter provides pushBatch.
+    template<typename Adapter, typename Elem>
+    void pushItems(Adapter& adapter, std::vector<Elem>& items)
+    {
+        if constexpr (requires { adapter.pushBatch(items); })
+        {
+            adapter.pushBatch(items);
+        }
+        else
+        {
+            for (auto& item : items)
+            {
+                adapter.push(std::move(item));
+            }
+            items.clear();
+        }
+    }
+
     template<typename Adapter>
     class ProducerConsumerBase
     {
@@ -39,6 +93,10 @@ namespace mt
     private:
         decltype(createThreadSafeSTLAdapterFrom(std::queue<Command>{})) m_commandQueue;
         std::unique_ptr<std::jthread> m_mainThread;
+        RealTimeOptions m_realTimeOptions;
+        RealTimeOptions m_workerRealTimeOptions;
+        std::chrono::steady_clock::time_point m_lastRest;
+        std::atomic<std::uint64_t> m_heartbeats{ 0 };
 
     protected:
         Adapter& m_sharedContainer;
@@ -57,15 +115,23 @@ namespace mt
 
         void enableWorkerThread();
         void disableWorkerThread();
+        void setRealTimeOptions(const RealTimeOptions& options);
+        [[nodiscard]] std::uint64_t heartbeats() const noexcept;
+        [[nodiscard]] bool workerThreadEnabled() const noexcept;
 
     protected:
         void runMainThread();
         void shutdownMainThread();
+        void onWork();
+        void onIdle();
 
     private:
         virtual void workerThreadWork() = 0;
+        virtual void prepareWorkerThread() { }
         void interruptWorkerThread();
         void mainThreadWork();
+        void applyRealTimeOptions();
+        void watchdog();
     };
 
     template<typename Adapter>
@@ -88,6 +154,97 @@ namespace mt
         m_commandQueue.pushAndNotify(Command::DisableWorkerThread);
     }
 
+    // Takes effect the next time the worker thread is enabled. A negative cpu leaves the worker unpinned.
+    template<typename Adapter>
+    void ProducerConsumerBase<Adapter>::setRealTimeOptions(const RealTimeOptions& options)
+    {
+        if (options.cpu >= CPU_SETSIZE)
+        {
+            throw InvalidCpu{};
+        }
+        std::lock_guard<std::mutex> lock(m_workerThreadMutex);
+        m_realTimeOptions = options;
+    }
+
+    // Advances on every pass of the worker loop; a worker whose count stops moving is stuck.
+    template<typename Adapter>
+    std::uint64_t ProducerConsumerBase<Adapter>::heartbeats() const noexcept
+    {
+        return m_heartbeats.load(std::memory_order_relaxed);
+    }
+
+    template<typename Adapter>
+    bool ProducerConsumerBase<Adapter>::workerThreadEnabled() const noexcept
+    {
+        return m_workerThreadEnabled.load(std::memory_order_relaxed);
+    }
+
+    template<typename Adapter>
+    void ProducerConsumerBase<Adapter>::onWork()
+    {
+        m_heartbeats.store(m_heartbeats.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (m_workerRealTimeOptions.enabled)
+        {
+            watchdog();
+        }
+    }
+
+    template<typename Adapter>
+    void ProducerConsumerBase<Adapter>::onIdle()
+    {
+        m_heartbeats.store(m_heartbeats.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (m_workerRealTimeOptions.enabled)
+        {
+            cpuRelax();
+            watchdog();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    template<typename Adapter>
+    void ProducerConsumerBase<Adapter>::watchdog()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - m_lastRest >= m_workerRealTimeOptions.watchdogPeriod)
+        {
+            std::this_thread::sleep_for(m_workerRealTimeOptions.backoff);
+            m_lastRest = std::chrono::steady_clock::now();
+        }
+    }
+
+    template<typename Adapter>
+    void ProducerConsumerBase<Adapter>::applyRealTimeOptions()
+    {
+        m_lastRest = std::chrono::steady_clock::now();
+        if (!m_workerRealTimeOptions.enabled)
+        {
+            return;
+        }
+        if (m_workerRealTimeOptions.lockMemory && ::mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        {
+            std::cerr << m_name << " -> mlockall failed" << std::endl;
+        }
+        if (m_workerRealTimeOptions.cpu >= 0)
+        {
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            CPU_SET(m_workerRealTimeOptions.cpu, &cpuSet);
+            if (::pthread_setaffinity_np(::pthread_self(), sizeof(cpuSet), &cpuSet) != 0)
+            {
+                std::cerr << m_name << " -> Failed to pin worker thread to CPU " << m_workerRealTimeOptions.cpu << std::endl;
+            }
+        }
+        sched_param param{};
+        param.sched_priority = m_workerRealTimeOptions.priority;
+        if (::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &param) != 0)
+        {
+            std::cerr << m_name << " -> Failed to set SCHED_FIFO priority " << m_workerRealTimeOptions.priority << std::endl;
+        }
+    }
+
     template<typename Adapter>
     void ProducerConsumerBase<Adapter>::runMainThread()
     {
@@ -153,10 +310,14 @@ namespace mt
                     {
                         std::lock_guard<std::mutex> lock(m_workerThreadMutex);
                         m_workerThreadEnabled = true;
+                        m_workerRealTimeOptions = m_realTimeOptions;
+                        prepareWorkerThread();
                         m_workerThread = std::make_unique<std::jthread>([&]
                             {
                                 try
                                 {
+                                    Tracer::setThreadName(m_name);
+                                    applyRealTimeOptions();
                                     workerThreadWork();
                                 }
                                 catch (const std::exception& ex)
@@ -0,0 +1,161 @@
+/**
+ * @file ProducerQuota.h
+ *
+ * @brief ProducerQuota class for limiting the rate and priority of elements pushed by one producer.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef PRODUCER_QUOTA_H
+#define PRODUCER_QUOTA_H
+
+#include "ThreadSafeSTLAdapter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace mt
+{
+    enum class QuotaPolicy : unsigned char
+    {
+        Demote,
+        Reject
+    };
+
+    // A token bucket refilled at ratePerSecond up to burst tokens, one token per element; a rate of
+    // zero disables it. Elements beyond the quota are either rejected or, for Prioritized elements,
+    // demoted to demotedPriority. Other elements cannot be demoted and are rejected under both
+    // policies. priorityCap clamps every Prioritized element, within the quota or not.
+    struct QuotaOptions
+    {
+        double ratePerSecond = 0.0;
+        double burst = 1.0;
+        QuotaPolicy policy = QuotaPolicy::Demote;
+        int priorityCap = std::numeric_limits<int>::max();
+        int demotedPriority = std::numeric_limits<int>::min();
+    };
+
+    struct QuotaStats
+    {
+        std::uint64_t capped = 0;
+        std::uint64_t demoted = 0;
+        std::uint64_t rejected = 0;
+    };
+
+    // Owned by one producer and applied by its pushing thread before the batch reaches the adapter,
+    // so the adapter lock is held no longer than without a quota and other producers are unaffected.
+    class ProducerQuota
+    {
+    private:
+        QuotaOptions m_options;
+        double m_tokens = 0.0;
+        std::chrono::steady_clock::time_point m_lastRefill;
+        std::atomic<std::uint64_t> m_capped{ 0 };
+        std::atomic<std::uint64_t> m_demoted{ 0 };
+        std::atomic<std::uint64_t> m_rejected{ 0 };
+
+    public:
+        ProducerQuota() = default;
+        ProducerQuota(const ProducerQuota&) = delete;
+        ProducerQuota(ProducerQuota&&) = delete;
+        ProducerQuota& operator=(const ProducerQuota&) = delete;
+        ProducerQuota& operator=(ProducerQuota&&) = delete;
+        ~ProducerQuota() = default;
+
+        // Starts with a full bucket. Must not run concurrently with apply.
+        void setOptions(const QuotaOptions& options);
+
+        // Removes rejected elements from items and adjusts the priorities of the rest.
+        template<typename Elem>
+        void apply(std::vector<Elem>& items);
+
+        [[nodiscard]] QuotaStats stats() const noexcept;
+
+    private:
+        [[nodiscard]] bool active() const noexcept;
+    };
+
+    inline void ProducerQuota::setOptions(const QuotaOptions& options)
+    {
+        m_options = options;
+        m_options.burst = std::max(m_options.burst, 1.0);
+        m_tokens = m_options.burst;
+        m_lastRefill = std::chrono::steady_clock::now();
+    }
+
+    inline bool ProducerQuota::active() const noexcept
+    {
+        return m_options.ratePerSecond > 0.0 || m_options.priorityCap != std::numeric_limits<int>::max();
+    }
+
+    template<typename Elem>
+    void ProducerQuota::apply(std::vector<Elem>& items)
+    {
+        if (!active())
+        {
+            return;
+        }
+        const bool limited = m_options.ratePerSecond > 0.0;
+        if (limited)
+        {
+            const auto now = std::chrono::steady_clock::now();
+            m_tokens = std::min(m_options.burst, m_tokens + std::chrono::duration<double>(now - m_lastRefill).count() * m_options.ratePerSecond);
+            m_lastRefill = now;
+        }
+
+        std::uint64_t capped = 0;
+        std::uint64_t demoted = 0;
+        auto kept = items.begin();
+        for (auto it = items.begin(); it != items.end(); ++it)
+        {
+            bool withinQuota = !limited || m_tokens >= 1.0;
+            if (limited && withinQuota)
+            {
+                m_tokens -= 1.0;
+            }
+            if constexpr (IsPrioritized<Elem>::value)
+            {
+                if (!withinQuota && m_options.policy == QuotaPolicy::Demote)
+                {
+                    it->priority = std::min(it->priority, m_options.demotedPriority);
+                    withinQuota = true;
+                    ++demoted;
+                }
+                if (it->priority > m_options.priorityCap)
+                {
+                    it->priority = m_options.priorityCap;
+                    ++capped;
+                }
+            }
+            if (withinQuota)
+            {
+                if (kept != it)
+                {
+                    *kept = std::move(*it);
+                }
+                ++kept;
+            }
+        }
+        const auto rejected = static_cast<std::uint64_t>(items.end() - kept);
+        items.erase(kept, items.end());
+
+        m_capped.store(m_capped.load(std::memory_order_relaxed) + capped, std::memory_order_relaxed);
+        m_demoted.store(m_demoted.load(std::memory_order_relaxed) + demoted, std::memory_order_relaxed);
+        m_rejected.store(m_rejected.load(std::memory_order_relaxed) + rejected, std::memory_order_relaxed);
+    }
+
+    inline QuotaStats ProducerQuota::stats() const noexcept
+    {
+        return QuotaStats{ m_capped.load(std::memory_order_relaxed), m_demoted.load(std::memory_order_relaxed),
+            m_rejected.load(std::memory_order_relaxed) };
+    }
+} // namespace mt
+
+#endif
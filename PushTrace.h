@@ -0,0 +1,204 @@
+/**
+ * @file PushTrace.h
+ *
+ * @brief PushTraceRecorder class for recording the push pattern of a Producer to a compact binary file.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef PUSH_TRACE_H
+#define PUSH_TRACE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace mt
+{
+    struct PushTraceWriteFailed : std::exception
+    {
+        [[nodiscard]] const char* what() const noexcept override { return "Exception: Failed to write the push trace"; }
+    };
+
+    struct PushTraceReadFailed : std::exception
+    {
+        [[nodiscard]] const char* what() const noexcept override { return "Exception: Failed to read the push trace"; }
+    };
+
+    struct PushRecord
+    {
+        std::int64_t offsetNs;
+        std::uint64_t items;
+        std::uint64_t bytes;
+    };
+
+    // Bytes an element carries: the payload of sized ranges such as strings and vectors, otherwise its object size.
+    template<typename T>
+    [[nodiscard]] std::uint64_t payloadBytes(const T& item)
+    {
+        if constexpr (requires { item.size(); typename T::value_type; })
+        {
+            return static_cast<std::uint64_t>(item.size() * sizeof(typename T::value_type));
+        }
+        else
+        {
+            return sizeof(T);
+        }
+    }
+
+    // Records one PushRecord per Producer::push call: its time since the recorder was created, the
+    // number of elements and their payload bytes. The file holds a magic, a version, the record
+    // count and then every record as LEB128 varints, the offset delta-encoded against the previous one.
+    class PushTraceRecorder
+    {
+    private:
+        static constexpr std::string_view Magic = "MTPT";
+        static constexpr std::uint64_t Version = 1;
+
+        mutable std::mutex m_mutex;
+        std::chrono::steady_clock::time_point m_start;
+        std::vector<PushRecord> m_records;
+
+    public:
+        PushTraceRecorder();
+        PushTraceRecorder(const PushTraceRecorder&) = delete;
+        PushTraceRecorder(PushTraceRecorder&&) = delete;
+        PushTraceRecorder& operator=(const PushTraceRecorder&) = delete;
+        PushTraceRecorder& operator=(PushTraceRecorder&&) = delete;
+        ~PushTraceRecorder() = default;
+
+        template<typename Elem>
+        void record(const std::vector<Elem>& items);
+
+        [[nodiscard]] std::vector<PushRecord> records() const;
+        void write(const std::filesystem::path& path) const;
+
+        [[nodiscard]] static std::vector<PushRecord> read(const std::filesystem::path& path);
+
+    private:
+        static void writeVarint(std::vector<char>& out, std::uint64_t value);
+        [[nodiscard]] static std::uint64_t readVarint(const std::vector<char>& in, std::size_t& pos);
+    };
+
+    inline PushTraceRecorder::PushTraceRecorder()
+        : m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    template<typename Elem>
+    void PushTraceRecorder::record(const std::vector<Elem>& items)
+    {
+        std::uint64_t bytes = 0;
+        for (const auto& item : items)
+        {
+            bytes += payloadBytes(item);
+        }
+        // Timestamps are taken under the lock so that offsets stay ordered across pushing threads.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto offset = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+        m_records.push_back(PushRecord{ static_cast<std::int64_t>(offset), items.size(), bytes });
+    }
+
+    inline std::vector<PushRecord> PushTraceRecorder::records() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_records;
+    }
+
+    inline void PushTraceRecorder::write(const std::filesystem::path& path) const
+    {
+        std::vector<char> out(Magic.cbegin(), Magic.cend());
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            writeVarint(out, Version);
+            writeVarint(out, m_records.size());
+            std::int64_t previous = 0;
+            for (const PushRecord& record : m_records)
+            {
+                writeVarint(out, static_cast<std::uint64_t>(record.offsetNs - previous));
+                writeVarint(out, record.items);
+                writeVarint(out, record.bytes);
+                previous = record.offsetNs;
+            }
+        }
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if (!file.flush())
+        {
+            throw PushTraceWriteFailed{};
+        }
+    }
+
+    inline std::vector<PushRecord> PushTraceRecorder::read(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            throw PushTraceReadFailed{};
+        }
+        const std::vector<char> in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (in.size() < Magic.size() || std::string_view(in.data(), Magic.size()) != Magic)
+        {
+            throw PushTraceReadFailed{};
+        }
+        std::size_t pos = Magic.size();
+        if (readVarint(in, pos) != Version)
+        {
+            throw PushTraceReadFailed{};
+        }
+        const std::uint64_t count = readVarint(in, pos);
+        std::vector<PushRecord> records;
+        records.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(count, in.size())));
+        std::int64_t offset = 0;
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            offset += static_cast<std::int64_t>(readVarint(in, pos));
+            const std::uint64_t items = readVarint(in, pos);
+            const std::uint64_t bytes = readVarint(in, pos);
+            records.push_back(PushRecord{ offset, items, bytes });
+        }
+        return records;
+    }
+
+    inline void PushTraceRecorder::writeVarint(std::vector<char>& out, std::uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    inline std::uint64_t PushTraceRecorder::readVarint(const std::vector<char>& in, std::size_t& pos)
+    {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            if (pos == in.size())
+            {
+                throw PushTraceReadFailed{};
+            }
+            const auto byte = static_cast<unsigned char>(in[pos++]);
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+        throw PushTraceReadFailed{};
+    }
+} // namespace mt
+
+#endif
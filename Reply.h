@@ -0,0 +1,364 @@
+/**
+ * @file Reply.h
+ *
+ * @brief Request elements and pooled, allocation-free reply handles for request/response pipelines.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef REPLY_H
+#define REPLY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace mt
+{
+    struct BrokenRequest : std::exception
+    {
+        [[nodiscard]] const char* what() const noexcept override { return "Exception: The request was destroyed without a reply"; }
+    };
+
+    template<typename R>
+    class ReplyPool;
+
+    template<typename R>
+    class ReplySlot
+    {
+    private:
+        enum State : std::uint32_t
+        {
+            Pending,
+            CallbackSet,
+            Ready
+        };
+
+        friend class ReplyPool<R>;
+        template<typename> friend class Reply;
+        template<typename, typename> friend class Request;
+
+        std::atomic<std::uint32_t> m_state{ Pending };
+        std::atomic<std::uint32_t> m_references{ 0 };
+        std::atomic<std::uint32_t> m_next{ 0 };
+        std::optional<R> m_value;
+        std::exception_ptr m_exception;
+        void (*m_callback)(void* context, R* value, std::exception_ptr exception) = nullptr;
+        void* m_context = nullptr;
+
+        void fulfill();
+        void reset() noexcept;
+    };
+
+    // Fixed set of reply slots with a lock-free free list. The pool is shared by the producer and
+    // every request and reply handed out from it, so it lives as long as the last of them.
+    template<typename R>
+    class ReplyPool
+    {
+    private:
+        static constexpr std::uint32_t Null = UINT32_MAX;
+
+        std::unique_ptr<ReplySlot<R>[]> m_slots;
+        std::atomic<std::uint64_t> m_freeHead;
+
+    public:
+        static constexpr std::size_t DefaultCapacity = 4096;
+
+        explicit ReplyPool(std::size_t capacity = DefaultCapacity);
+        ReplyPool(const ReplyPool&) = delete;
+        ReplyPool(ReplyPool&&) = delete;
+        ReplyPool& operator=(const ReplyPool&) = delete;
+        ReplyPool& operator=(ReplyPool&&) = delete;
+        ~ReplyPool() = default;
+
+        [[nodiscard]] ReplySlot<R>* tryAcquire() noexcept;
+        void release(ReplySlot<R>* slot) noexcept;
+    };
+
+    template<typename R>
+    class Reply
+    {
+    private:
+        std::shared_ptr<ReplyPool<R>> m_pool;
+        ReplySlot<R>* m_slot = nullptr;
+
+    public:
+        using Callback = void (*)(void* context, R* value, std::exception_ptr exception);
+
+        Reply() = default;
+        Reply(std::shared_ptr<ReplyPool<R>> pool, ReplySlot<R>* slot) noexcept;
+        Reply(const Reply&) = delete;
+        Reply(Reply&& rhs) noexcept;
+        Reply& operator=(const Reply&) = delete;
+        Reply& operator=(Reply&& rhs) noexcept;
+        ~Reply();
+
+        [[nodiscard]] bool valid() const noexcept { return m_slot != nullptr; }
+        [[nodiscard]] bool ready() const noexcept;
+        void wait() const noexcept;
+        R get();
+        // The callback runs on the consumer thread, or immediately if the reply is already ready.
+        void onReady(Callback callback, void* context);
+    };
+
+    // Queue element carrying a value to the consumer and the slot its result is delivered to.
+    template<typename T, typename R>
+    class Request
+    {
+    private:
+        std::shared_ptr<ReplyPool<R>> m_pool;
+        ReplySlot<R>* m_slot = nullptr;
+
+    public:
+        using Value = T;
+        using Result = R;
+
+        T value{};
+
+        Request() = default;
+        Request(T value, std::shared_ptr<ReplyPool<R>> pool, ReplySlot<R>* slot) noexcept(std::is_nothrow_move_constructible_v<T>);
+        Request(const Request&) = delete;
+        Request(Request&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>);
+        Request& operator=(const Request&) = delete;
+        Request& operator=(Request&& rhs) noexcept(std::is_nothrow_move_assignable_v<T>);
+        ~Request();
+
+        template<typename Callable>
+        void complete(Callable& callable);
+
+    private:
+        void abandon() noexcept;
+    };
+
+    template<typename T>
+    struct IsRequest : std::false_type { };
+
+    template<typename T, typename R>
+    struct IsRequest<Request<T, R>> : std::true_type { };
+
+    template<typename R>
+    void ReplySlot<R>::fulfill()
+    {
+        if (m_state.exchange(Ready, std::memory_order_acq_rel) == CallbackSet)
+        {
+            m_callback(m_context, m_value ? &*m_value : nullptr, m_exception);
+        }
+        m_state.notify_all();
+    }
+
+    template<typename R>
+    void ReplySlot<R>::reset() noexcept
+    {
+        m_value.reset();
+        m_exception = nullptr;
+        m_callback = nullptr;
+        m_context = nullptr;
+        m_state.store(Pending, std::memory_order_relaxed);
+    }
+
+    template<typename R>
+    ReplyPool<R>::ReplyPool(const std::size_t capacity)
+        : m_slots(std::make_unique<ReplySlot<R>[]>(capacity))
+        , m_freeHead(capacity == 0 ? Null : 0)
+    {
+        static_assert(!std::is_void_v<R>, "Reply requires a non-void result type");
+        for (std::size_t i = 0; i < capacity; ++i)
+        {
+            m_slots[i].m_next.store(i + 1 < capacity ? static_cast<std::uint32_t>(i + 1) : Null, std::memory_order_relaxed);
+        }
+    }
+
+    // The head carries a tag next to the slot index to rule out ABA on concurrent acquire/release.
+    template<typename R>
+    ReplySlot<R>* ReplyPool<R>::tryAcquire() noexcept
+    {
+        std::uint64_t head = m_freeHead.load(std::memory_order_acquire);
+        while (true)
+        {
+            const auto index = static_cast<std::uint32_t>(head);
+            if (index == Null)
+            {
+                return nullptr;
+            }
+            const std::uint32_t next = m_slots[index].m_next.load(std::memory_order_relaxed);
+            const std::uint64_t newHead = (((head >> 32) + 1) << 32) | next;
+            if (m_freeHead.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire))
+            {
+                ReplySlot<R>* const slot = &m_slots[index];
+                slot->m_references.store(2, std::memory_order_relaxed);
+                return slot;
+            }
+        }
+    }
+
+    template<typename R>
+    void ReplyPool<R>::release(ReplySlot<R>* const slot) noexcept
+    {
+        if (slot->m_references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+        slot->reset();
+        const auto index = static_cast<std::uint32_t>(slot - m_slots.get());
+        std::uint64_t head = m_freeHead.load(std::memory_order_relaxed);
+        do
+        {
+            slot->m_next.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+        } while (!m_freeHead.compare_exchange_weak(head, (((head >> 32) + 1) << 32) | index,
+            std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    template<typename R>
+    Reply<R>::Reply(std::shared_ptr<ReplyPool<R>> pool, ReplySlot<R>* const slot) noexcept
+        : m_pool(std::move(pool))
+        , m_slot(slot)
+    { }
+
+    template<typename R>
+    Reply<R>::Reply(Reply&& rhs) noexcept
+        : m_pool(std::move(rhs.m_pool))
+        , m_slot(std::exchange(rhs.m_slot, nullptr))
+    { }
+
+    template<typename R>
+    Reply<R>& Reply<R>::operator=(Reply&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            if (m_slot)
+            {
+                m_pool->release(m_slot);
+            }
+            m_pool = std::move(rhs.m_pool);
+            m_slot = std::exchange(rhs.m_slot, nullptr);
+        }
+        return *this;
+    }
+
+    template<typename R>
+    Reply<R>::~Reply()
+    {
+        if (m_slot)
+        {
+            m_pool->release(m_slot);
+        }
+    }
+
+    template<typename R>
+    bool Reply<R>::ready() const noexcept
+    {
+        return m_slot->m_state.load(std::memory_order_acquire) == ReplySlot<R>::Ready;
+    }
+
+    template<typename R>
+    void Reply<R>::wait() const noexcept
+    {
+        std::uint32_t state = m_slot->m_state.load(std::memory_order_acquire);
+        while (state != ReplySlot<R>::Ready)
+        {
+            m_slot->m_state.wait(state, std::memory_order_acquire);
+            state = m_slot->m_state.load(std::memory_order_acquire);
+        }
+    }
+
+    template<typename R>
+    R Reply<R>::get()
+    {
+        wait();
+        if (m_slot->m_exception)
+        {
+            std::rethrow_exception(m_slot->m_exception);
+        }
+        return std::move(*m_slot->m_value);
+    }
+
+    template<typename R>
+    void Reply<R>::onReady(const Callback callback, void* const context)
+    {
+        m_slot->m_callback = callback;
+        m_slot->m_context = context;
+        std::uint32_t expected = ReplySlot<R>::Pending;
+        if (!m_slot->m_state.compare_exchange_strong(expected, ReplySlot<R>::CallbackSet, std::memory_order_acq_rel))
+        {
+            callback(context, m_slot->m_value ? &*m_slot->m_value : nullptr, m_slot->m_exception);
+        }
+    }
+
+    template<typename T, typename R>
+    Request<T, R>::Request(T value, std::shared_ptr<ReplyPool<R>> pool, ReplySlot<R>* const slot) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : m_pool(std::move(pool))
+        , m_slot(slot)
+        , value(std::move(value))
+    { }
+
+    template<typename T, typename R>
+    Request<T, R>::Request(Request&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : m_pool(std::move(rhs.m_pool))
+        , m_slot(std::exchange(rhs.m_slot, nullptr))
+        , value(std::move(rhs.value))
+    { }
+
+    template<typename T, typename R>
+    Request<T, R>& Request<T, R>::operator=(Request&& rhs) noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        if (this != &rhs)
+        {
+            abandon();
+            m_pool = std::move(rhs.m_pool);
+            m_slot = std::exchange(rhs.m_slot, nullptr);
+            value = std::move(rhs.value);
+        }
+        return *this;
+    }
+
+    template<typename T, typename R>
+    Request<T, R>::~Request()
+    {
+        abandon();
+    }
+
+    template<typename T, typename R>
+    template<typename Callable>
+    void Request<T, R>::complete(Callable& callable)
+    {
+        try
+        {
+            m_slot->m_value.emplace(callable(std::move_if_noexcept(value)));
+        }
+        catch (...)
+        {
+            m_slot->m_exception = std::current_exception();
+        }
+        m_slot->fulfill();
+        m_pool->release(std::exchange(m_slot, nullptr));
+    }
+
+    // A request dropped before completion is answered with BrokenRequest, so no waiter hangs.
+    template<typename T, typename R>
+    void Request<T, R>::abandon() noexcept
+    {
+        if (!m_slot)
+        {
+            return;
+        }
+        m_slot->m_exception = std::make_exception_ptr(BrokenRequest{});
+        try
+        {
+            m_slot->fulfill();
+        }
+        catch (...)
+        {
+        }
+        m_pool->release(std::exchange(m_slot, nullptr));
+    }
+} // namespace mt
+
+#endif
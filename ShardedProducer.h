@@ -0,0 +1,136 @@
+/**
+ * @file ShardedProducer.h
+ *
+ * @brief ShardedProducer class for spreading pushed elements across several shared thread-safe containers.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef SHARDED_PRODUCER_H
+#define SHARDED_PRODUCER_H
+
+#include "Producer.h"
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+namespace mt
+{
+    struct RoundRobinRouting { };
+
+    // Routes every pushed element to one of N adapters, typically each drained by its own Consumer,
+    // so every adapter lock sees a fraction of the traffic. A Router callable maps an element to a
+    // hash, which keeps all elements of a key on one shard in push order; RoundRobinRouting spreads
+    // them evenly instead. Each pushed batch is split per shard and every part is pushed with one
+    // lock acquisition.
+    template<typename Adapter, typename Router = RoundRobinRouting>
+    class ShardedProducer : public ProducerConsumerBase<std::vector<std::reference_wrapper<Adapter>>>
+    {
+    public:
+        using Shards = std::vector<std::reference_wrapper<Adapter>>;
+        using Elem = typename Adapter::Elem;
+
+    private:
+        using Super = ProducerConsumerBase<Shards>;
+
+        decltype(createThreadSafeSTLAdapterFrom(std::queue<std::vector<Elem>>{})) m_vectorItemsQueue;
+        [[no_unique_address]] Router m_router;
+        std::size_t m_nextShard = 0;
+        std::vector<std::vector<Elem>> m_shardItems;
+
+    public:
+        explicit ShardedProducer(Shards& shards, Router router = Router{});
+        ShardedProducer(const ShardedProducer&) = delete;
+        ShardedProducer(ShardedProducer&&) = delete;
+        ShardedProducer& operator=(const ShardedProducer&) = delete;
+        ShardedProducer& operator=(ShardedProducer&&) = delete;
+        ~ShardedProducer() override;
+
+        void push(std::vector<Elem> items);
+
+    private:
+        void workerThreadWork() override;
+        [[nodiscard]] std::size_t shardOf(const Elem& item);
+    };
+
+    template<typename Adapter, typename Router>
+    ShardedProducer<Adapter, Router>::ShardedProducer(Shards& shards, Router router)
+        : Super(Super::Type::Producer, shards)
+        , m_vectorItemsQueue(createThreadSafeSTLAdapterFrom(std::queue<std::vector<Elem>>{}))
+        , m_router(std::move(router))
+    {
+        this->runMainThread();
+    }
+
+    template<typename Adapter, typename Router>
+    ShardedProducer<Adapter, Router>::~ShardedProducer()
+    {
+        this->shutdownMainThread();
+    }
+
+    template<typename Adapter, typename Router>
+    void ShardedProducer<Adapter, Router>::push(std::vector<Elem> items)
+    {
+        TraceScope scope("Producer::push");
+        m_vectorItemsQueue.push(std::move(items));
+    }
+
+    template<typename Adapter, typename Router>
+    std::size_t ShardedProducer<Adapter, Router>::shardOf(const Elem& item)
+    {
+        const std::size_t count = this->m_sharedContainer.size();
+        if constexpr (std::is_same_v<Router, RoundRobinRouting>)
+        {
+            const std::size_t shard = m_nextShard;
+            m_nextShard = shard + 1 == count ? 0 : shard + 1;
+            return shard;
+        }
+        else
+        {
+            return static_cast<std::size_t>(std::invoke(m_router, item)) % count;
+        }
+    }
+
+    template<typename Adapter, typename Router>
+    void ShardedProducer<Adapter, Router>::workerThreadWork()
+    {
+        const std::size_t count = this->m_sharedContainer.size();
+        if (count == 0)
+        {
+            return;
+        }
+        m_shardItems.resize(count);
+        m_nextShard %= count;
+        while (this->m_workerThreadEnabled)
+        {
+            std::vector<Elem> vectorItem;
+            if (m_vectorItemsQueue.tryPop(vectorItem))
+            {
+                TraceScope scope("Producer::transfer");
+                for (auto& item : vectorItem)
+                {
+                    m_shardItems[shardOf(item)].push_back(std::move(item));
+                }
+                for (std::size_t shard = 0; shard < count; ++shard)
+                {
+                    if (!m_shardItems[shard].empty())
+                    {
+                        pushItems(this->m_sharedContainer[shard].get(), m_shardItems[shard]);
+                    }
+                }
+                this->onWork();
+            }
+            else
+            {
+                this->onIdle();
+            }
+        }
+    }
+} // namespace mt
+
+#endif
@@ -0,0 +1,197 @@
+/**
+ * @file StallWatchdog.h
+ *
+ * @brief StallWatchdog class for moving pending items away from consumers that stopped making progress.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef STALL_WATCHDOG_H
+#define STALL_WATCHDOG_H
+
+#include "ProducerConsumerBase.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <stop_token>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace mt
+{
+    // Watches lanes, each an adapter drained by its own worker. A worker whose heartbeat count has
+    // not moved for a whole period while its lane holds items is considered stalled, and the
+    // pending items of its lane are moved to the lanes whose workers did make progress, emptiest
+    // first. New items reaching a stalled lane are moved on every period until its worker beats again.
+    template<typename Adapter>
+    class StallWatchdog
+    {
+    public:
+        using Elem = typename Adapter::Elem;
+
+        struct Lane
+        {
+            Adapter& adapter;
+            const ProducerConsumerBase<Adapter>& worker;
+        };
+
+    private:
+        struct LaneState
+        {
+            std::uint64_t heartbeats = 0;
+            bool stalled = false;
+        };
+
+        static constexpr std::string_view Name = "WATCHDOG";
+
+        std::vector<Lane> m_lanes;
+        std::vector<LaneState> m_states;
+        std::chrono::milliseconds m_period;
+        std::atomic<std::uint64_t> m_migrated{ 0 };
+        std::mutex m_mutex;
+        std::condition_variable_any m_condVar;
+        std::jthread m_thread;
+
+    public:
+        explicit StallWatchdog(std::vector<Lane> lanes, std::chrono::milliseconds period = std::chrono::milliseconds(100));
+        StallWatchdog(const StallWatchdog&) = delete;
+        StallWatchdog(StallWatchdog&&) = delete;
+        StallWatchdog& operator=(const StallWatchdog&) = delete;
+        StallWatchdog& operator=(StallWatchdog&&) = delete;
+        ~StallWatchdog() = default;
+
+        [[nodiscard]] std::uint64_t migratedCount() const noexcept;
+
+    private:
+        void watchdogThreadWork(std::stop_token stopToken);
+        void check();
+        void migrate(std::size_t from, const std::vector<std::size_t>& healthy);
+    };
+
+    template<typename Adapter>
+    StallWatchdog<Adapter>::StallWatchdog(std::vector<Lane> lanes, const std::chrono::milliseconds period)
+        : m_lanes(std::move(lanes))
+        , m_states(m_lanes.size())
+        , m_period(period)
+    {
+        for (std::size_t i = 0; i < m_lanes.size(); ++i)
+        {
+            m_states[i].heartbeats = m_lanes[i].worker.heartbeats();
+        }
+        m_thread = std::jthread([this](const std::stop_token stopToken) { watchdogThreadWork(stopToken); });
+    }
+
+    template<typename Adapter>
+    std::uint64_t StallWatchdog<Adapter>::migratedCount() const noexcept
+    {
+        return m_migrated.load(std::memory_order_relaxed);
+    }
+
+    template<typename Adapter>
+    void StallWatchdog<Adapter>::watchdogThreadWork(const std::stop_token stopToken)
+    {
+        try
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (true)
+            {
+                m_condVar.wait_for(lock, stopToken, m_period, [] { return false; });
+                if (stopToken.stop_requested())
+                {
+                    return;
+                }
+                check();
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << Name << " -> " << ex.what() << std::endl;
+        }
+        catch (...)
+        {
+            std::cerr << Name << " -> Unknown exception" << std::endl;
+        }
+    }
+
+    template<typename Adapter>
+    void StallWatchdog<Adapter>::check()
+    {
+        std::vector<std::size_t> stalled;
+        std::vector<std::size_t> healthy;
+        for (std::size_t i = 0; i < m_lanes.size(); ++i)
+        {
+            const std::uint64_t heartbeats = m_lanes[i].worker.heartbeats();
+            const bool progressed = heartbeats != m_states[i].heartbeats;
+            m_states[i].heartbeats = heartbeats;
+            if (progressed)
+            {
+                if (m_states[i].stalled)
+                {
+                    std::cerr << Name << " -> Lane " << i << " recovered" << std::endl;
+                }
+                m_states[i].stalled = false;
+                healthy.push_back(i);
+            }
+            else if (m_states[i].stalled || !m_lanes[i].adapter.emptyApprox())
+            {
+                if (!m_states[i].stalled)
+                {
+                    std::cerr << Name << " -> Lane " << i << " stalled" << std::endl;
+                }
+                m_states[i].stalled = true;
+                stalled.push_back(i);
+            }
+        }
+        if (healthy.empty())
+        {
+            return;
+        }
+        for (const std::size_t lane : stalled)
+        {
+            migrate(lane, healthy);
+        }
+    }
+
+    template<typename Adapter>
+    void StallWatchdog<Adapter>::migrate(const std::size_t from, const std::vector<std::size_t>& healthy)
+    {
+        std::vector<Elem> items;
+        const std::size_t count = m_lanes[from].adapter.tryPopBatch(items, m_lanes[from].adapter.sizeApprox());
+        if (count == 0)
+        {
+            return;
+        }
+        m_migrated.fetch_add(count, std::memory_order_relaxed);
+
+        // Level the healthy lanes: each part goes to the lane that is emptiest at that point.
+        std::vector<std::size_t> sizes;
+        sizes.reserve(healthy.size());
+        for (const std::size_t lane : healthy)
+        {
+            sizes.push_back(m_lanes[lane].adapter.sizeApprox());
+        }
+        const std::size_t chunk = (count + healthy.size() - 1) / healthy.size();
+        std::vector<Elem> part;
+        for (std::size_t begin = 0; begin < count; begin += chunk)
+        {
+            const std::size_t end = std::min(begin + chunk, count);
+            const std::size_t target = static_cast<std::size_t>(std::min_element(sizes.cbegin(), sizes.cend()) - sizes.cbegin());
+            part.assign(std::make_move_iterator(items.begin() + begin), std::make_move_iterator(items.begin() + end));
+            pushItems(m_lanes[healthy[target]].adapter, part);
+            sizes[target] += end - begin;
+        }
+    }
+} // namespace mt
+
+#endif
@@ -12,9 +12,32 @@
 #ifndef THREAD_SAFE_STL_ADAPTER_H
 #define THREAD_SAFE_STL_ADAPTER_H
 
+#include "Trace.h"
+
 #include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <iostream>
 #include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace mt
 {
@@ -23,6 +46,83 @@ namespace mt
         [[nodiscard]] const char* what() const noexcept override { return "Exception: The adapter is empty"; }
     };
 
+    struct InvalidWatermarks : std::exception
+    {
+        [[nodiscard]] const char* what() const noexcept override { return "Exception: The low watermark must be below the high watermark"; }
+    };
+
+    struct CheckpointWriteFailed : std::exception
+    {
+        [[nodiscard]] const char* what() const noexcept override { return "Exception: Failed to write the checkpoint"; }
+    };
+
+    // The new checkpoint is in place and readable, but a crash may still bring back the old one.
+    struct CheckpointNotDurable : std::exception
+    {
+        [[nodiscard]] const char* what() const noexcept override { return "Exception: The checkpoint was written but its directory could not be synced"; }
+    };
+
+    struct CheckpointRestoreFailed : std::exception
+    {
+        [[nodiscard]] const char* what() const noexcept override { return "Exception: Failed to restore from the checkpoint"; }
+    };
+
+    struct CheckpointHeader
+    {
+        static constexpr char Magic[8] = { 'M', 'T', 'C', 'K', 'P', 'T', '0', '1' };
+
+        char magic[8];
+        std::uint64_t elemSize;
+        std::uint64_t count;
+    };
+
+    // Element wrapper whose value is dropped at dequeue instead of being delivered once deadline has passed.
+    template<typename T>
+    struct Expiring
+    {
+        using Clock = std::chrono::steady_clock;
+
+        T value{};
+        Clock::time_point deadline = Clock::time_point::max();
+    };
+
+    template<typename T>
+    struct IsExpiring : std::false_type { };
+
+    template<typename T>
+    struct IsExpiring<Expiring<T>> : std::true_type { };
+
+    // Element wrapper ordered by priority alone, so std::priority_queue with std::less puts the highest
+    // priority on top. ProducerQuota caps and demotes the priority of these elements.
+    template<typename T>
+    struct Prioritized
+    {
+        T value{};
+        int priority = 0;
+
+        [[nodiscard]] friend bool operator<(const Prioritized& lhs, const Prioritized& rhs) noexcept
+        {
+            return lhs.priority < rhs.priority;
+        }
+    };
+
+    template<typename T>
+    struct IsPrioritized : std::false_type { };
+
+    template<typename T>
+    struct IsPrioritized<Prioritized<T>> : std::true_type { };
+
+    // Comparator for std::priority_queue that puts the earliest deadline on top. Expired elements
+    // then always sit at the top, where dequeues drop them.
+    struct EarliestDeadlineFirst
+    {
+        template<typename T>
+        [[nodiscard]] bool operator()(const Expiring<T>& lhs, const Expiring<T>& rhs) const noexcept
+        {
+            return rhs.deadline < lhs.deadline;
+        }
+    };
+
     template<typename Adapter>
     [[nodiscard]] constexpr auto detectTopMethodImpl(const Adapter* const p) noexcept -> decltype(p->top(), void(), true) { return true; }
 
@@ -31,6 +131,36 @@ namespace mt
     template<typename Adapter>
     [[nodiscard]] constexpr bool detectTopMethod() noexcept { return detectTopMethodImpl(static_cast<const Adapter* const>(nullptr)); }
 
+    template<typename Container>
+    [[nodiscard]] constexpr auto detectReserveMethodImpl(Container* const p) noexcept -> decltype(p->reserve(0), void(), true) { return true; }
+
+    [[nodiscard]] constexpr bool detectReserveMethodImpl(const void* const) noexcept { return false; }
+
+    template<typename Container>
+    [[nodiscard]] constexpr bool detectReserveMethod() noexcept { return detectReserveMethodImpl(static_cast<Container* const>(nullptr)); }
+
+    template<typename Container>
+    [[nodiscard]] constexpr auto detectShrinkToFitMethodImpl(Container* const p) noexcept -> decltype(p->shrink_to_fit(), void(), true) { return true; }
+
+    [[nodiscard]] constexpr bool detectShrinkToFitMethodImpl(const void* const) noexcept { return false; }
+
+    template<typename Container>
+    [[nodiscard]] constexpr bool detectShrinkToFitMethod() noexcept { return detectShrinkToFitMethodImpl(static_cast<Container* const>(nullptr)); }
+
+    // Containers such as std::vector report being copyable even when their elements are not.
+    template<typename T>
+    [[nodiscard]] constexpr bool isDeeplyCopyable() noexcept
+    {
+        if constexpr (requires { typename T::value_type; })
+        {
+            return std::is_copy_constructible_v<T> && std::is_copy_assignable_v<T> && isDeeplyCopyable<typename T::value_type>();
+        }
+        else
+        {
+            return std::is_copy_constructible_v<T> && std::is_copy_assignable_v<T>;
+        }
+    }
+
     template<typename Adapter>
     [[nodiscard]] auto& getCurrent(const Adapter& adapter)
     {
@@ -49,6 +179,16 @@ namespace mt
         typename ContElem, template<typename> typename Alloc,
         typename AllocElem, typename... Ts>
     class ThreadSafeSTLAdapter;
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    [[nodiscard]] const Cont<ContElem, Alloc<AllocElem>>& getProtectedContainer(const Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>& adapter);
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    [[nodiscard]] Cont<ContElem, Alloc<AllocElem>>& getProtectedContainer(Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>& adapter);
     template<template<typename...> typename Adapt,
         typename AdaptElem, template<typename...> typename Cont,
         typename ContElem, template<typename> typename Alloc,
@@ -67,10 +207,57 @@ namespace mt
     {
     private:
         Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...> m_adapter;
-        std::mutex m_mutex;
+        Alloc<typename AdaptElem::element_type> m_elemAllocator;
+        mutable std::mutex m_mutex;
         std::condition_variable m_condVar;
 
+        // Written under m_mutex and read lock-free. Kept apart from the mutex so that
+        // readers polling them do not bounce its cache line.
+        struct alignas(64) Counters
+        {
+            std::atomic<std::uint64_t> version{ 0 };
+            std::atomic<std::size_t> size{ 0 };
+            std::atomic<std::size_t> highWaterMark{ 0 };
+            std::atomic<std::uint64_t> expired{ 0 };
+            std::atomic<std::uint64_t> enqueued{ 0 };
+            std::atomic<std::uint64_t> dequeued{ 0 };
+        };
+        Counters m_counters;
+        std::chrono::steady_clock::duration m_timeToLive{ 0 };
+
+        struct Watermarks
+        {
+            std::size_t high;
+            std::size_t low;
+            std::function<void()> onHigh;
+            std::function<void()> onLow;
+        };
+        enum class WatermarkCrossing : unsigned char
+        {
+            None,
+            High,
+            Low
+        };
+        struct PendingCrossing
+        {
+            std::shared_ptr<const Watermarks> watermarks;
+            WatermarkCrossing crossing = WatermarkCrossing::None;
+            std::uint64_t sequence = 0;
+        };
+        std::shared_ptr<const Watermarks> m_watermarks;
+        bool m_aboveHighWatermark = false;
+        WatermarkCrossing m_pendingCrossing = WatermarkCrossing::None;
+        std::uint64_t m_crossingSequence = 0;
+        std::uint64_t m_firedCrossingSequence = 0;
+        std::recursive_mutex m_watermarkMutex;
+
+        class ModificationLock;
+
+        struct PublishedSnapshot;
+        std::atomic<std::weak_ptr<const PublishedSnapshot>> m_publishedSnapshot;
+
         explicit ThreadSafeSTLAdapter(Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>&& adapter);
+        ThreadSafeSTLAdapter(const ThreadSafeSTLAdapter& rhs, const std::unique_lock<std::mutex>& rhsLock);
 
         template<template<typename...> typename Adapt_,
             typename AdaptElem_, template<typename...> typename Cont_,
@@ -84,8 +271,21 @@ namespace mt
             typename AllocElem_, typename... Ts_>
         [[nodiscard]] friend auto createThreadSafeSTLAdapterFrom(Adapt_<AdaptElem_, Cont_<ContElem_, Alloc_<AllocElem_>>, Ts_...>&& adapter, Ts_... comparator);
 
+        template<typename ExecutionPolicy, template<typename...> typename Adapt_,
+            typename AdaptElem_, template<typename...> typename Cont_,
+            typename ContElem_, template<typename> typename Alloc_,
+            typename AllocElem_, typename... Ts_>
+        friend auto createThreadSafeSTLAdapterFrom(ExecutionPolicy&& policy, const Adapt_<AdaptElem_, Cont_<ContElem_, Alloc_<AllocElem_>>, Ts_...>& adapter, Ts_... comparator);
+
+        template<typename ExecutionPolicy, template<typename...> typename Adapt_,
+            typename AdaptElem_, template<typename...> typename Cont_,
+            typename ContElem_, template<typename> typename Alloc_,
+            typename AllocElem_, typename... Ts_>
+        friend auto createThreadSafeSTLAdapterFrom(ExecutionPolicy&& policy, Adapt_<AdaptElem_, Cont_<ContElem_, Alloc_<AllocElem_>>, Ts_...>&& adapter, Ts_... comparator);
+
     public:
         using Elem = typename AdaptElem::element_type;
+        using Snapshot = std::vector<std::shared_ptr<const Elem>>;
 
         ThreadSafeSTLAdapter(const ThreadSafeSTLAdapter& rhs);
         ThreadSafeSTLAdapter(ThreadSafeSTLAdapter&& rhs);
@@ -95,17 +295,118 @@ namespace mt
 
         void push(Elem value);
         void pushAndNotify(Elem value);
+        void pushBatch(std::vector<Elem>& values);
 
         void waitAndPop(Elem& value);
         std::shared_ptr<Elem> waitAndPop();
 
         bool tryPop(Elem& value);
         std::shared_ptr<Elem> tryPop();
+        std::size_t tryPopBatch(std::vector<Elem>& values, std::size_t maxCount);
 
         void pop(Elem& value);
         std::shared_ptr<Elem> pop();
 
+        void reserve(std::size_t capacity);
+        void shrinkToFit();
+
+        [[nodiscard]] std::size_t sizeApprox() const noexcept;
+        [[nodiscard]] bool emptyApprox() const noexcept;
+        [[nodiscard]] std::size_t highWaterMark() const noexcept;
+        void resetHighWaterMark() noexcept;
+        [[nodiscard]] std::uint64_t enqueuedCount() const noexcept;
+        [[nodiscard]] std::uint64_t dequeuedCount() const noexcept;
+
+        void setTimeToLive(std::chrono::steady_clock::duration timeToLive);
+        std::size_t purgeExpired();
+        [[nodiscard]] std::uint64_t expiredCount() const noexcept;
+
+        void setWatermarks(std::size_t high, std::size_t low, std::function<void()> onHigh, std::function<void()> onLow);
+
+        [[nodiscard]] std::shared_ptr<const Snapshot> snapshot();
+
+        void checkpoint(const std::filesystem::path& path);
+        void restoreFrom(const std::filesystem::path& path);
+
         void swap(ThreadSafeSTLAdapter& rhs);
+
+    private:
+        void markModifiedLocked() noexcept;
+        [[nodiscard]] PendingCrossing takePendingCrossingLocked() noexcept;
+        void fireWatermarkCrossing(const PendingCrossing& pending) noexcept;
+        [[nodiscard]] static bool isSharedLocked(const std::shared_ptr<Elem>& item) noexcept;
+        void takeCurrentLocked(Elem& value);
+        [[nodiscard]] std::shared_ptr<Elem> takeCurrentLocked();
+        [[nodiscard]] bool dropExpiredLocked();
+        void applyTimeToLiveLocked(Elem& value) const;
+    };
+
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    class ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::ModificationLock
+    {
+    private:
+        ThreadSafeSTLAdapter& m_owner;
+        std::unique_lock<std::mutex> m_lock;
+        bool m_traced;
+        std::int64_t m_requestedNs = 0;
+        std::int64_t m_acquiredNs = 0;
+        std::uint64_t m_version = 0;
+
+    public:
+        // Only operations that changed the container are traced, so that idle polls of empty
+        // adapters do not fill the trace buffers; the events are emitted once that is known.
+        explicit ModificationLock(ThreadSafeSTLAdapter& owner)
+            : m_owner(owner)
+            , m_lock(owner.m_mutex, std::defer_lock)
+            , m_traced(Tracer::enabled())
+        {
+            if (m_traced)
+            {
+                m_requestedNs = Tracer::now();
+            }
+            m_lock.lock();
+            if (m_traced)
+            {
+                m_acquiredNs = Tracer::now();
+                m_version = m_owner.m_counters.version.load(std::memory_order_relaxed);
+            }
+        }
+        ModificationLock(const ModificationLock&) = delete;
+        ModificationLock& operator=(const ModificationLock&) = delete;
+
+        // Watermark callbacks run only after the adapter lock has been released.
+        ~ModificationLock()
+        {
+            if (m_traced && m_owner.m_counters.version.load(std::memory_order_relaxed) != m_version)
+            {
+                Tracer::beginAt("ThreadSafeSTLAdapter::lock", m_requestedNs);
+                Tracer::endAt("ThreadSafeSTLAdapter::lock", m_acquiredNs);
+                Tracer::beginAt("ThreadSafeSTLAdapter::locked", m_acquiredNs);
+                Tracer::endAt("ThreadSafeSTLAdapter::locked", Tracer::now());
+            }
+            const PendingCrossing pending = m_owner.takePendingCrossingLocked();
+            if (pending.crossing == WatermarkCrossing::None)
+            {
+                return;
+            }
+            m_lock.unlock();
+            m_owner.fireWatermarkCrossing(pending);
+        }
+
+        [[nodiscard]] std::unique_lock<std::mutex>& get() noexcept { return m_lock; }
+    };
+
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    struct ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::PublishedSnapshot
+    {
+        std::uint64_t version;
+        Snapshot items;
     };
 
     template<template<typename...> typename Adapt,
@@ -115,7 +416,10 @@ namespace mt
     ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::
         ThreadSafeSTLAdapter(Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>&& adapter)
         : m_adapter(std::move(adapter))
-    { }
+        , m_elemAllocator(getProtectedContainer(m_adapter).get_allocator())
+    {
+        markModifiedLocked();
+    }
 
     template<template<typename...> typename Adapt,
         typename AdaptElem, template<typename...> typename Cont,
@@ -123,9 +427,20 @@ namespace mt
         typename AllocElem, typename... Ts>
     ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::
         ThreadSafeSTLAdapter(const ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>& rhs)
+        : ThreadSafeSTLAdapter(rhs, std::unique_lock<std::mutex>(rhs.m_mutex))
+    { }
+
+    // Copies with rhs's allocator, which for std::pmr containers a plain copy would not propagate.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::
+        ThreadSafeSTLAdapter(const ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>& rhs, const std::unique_lock<std::mutex>&)
+        : m_adapter(rhs.m_adapter, getProtectedContainer(rhs.m_adapter).get_allocator())
+        , m_elemAllocator(rhs.m_elemAllocator)
     {
-        std::lock_guard<std::mutex> lock(rhs.m_mutex);
-        m_adapter = rhs.m_adapter;
+        markModifiedLocked();
     }
 
     template<template<typename...> typename Adapt,
@@ -134,9 +449,18 @@ namespace mt
         typename AllocElem, typename... Ts>
     ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::
         ThreadSafeSTLAdapter(ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>&& rhs)
+        : m_adapter(getProtectedContainer(rhs.m_adapter).get_allocator())
+        , m_elemAllocator(rhs.m_elemAllocator)
     {
-        std::lock_guard<std::mutex> lock(rhs.m_mutex);
-        m_adapter = std::move_if_noexcept(rhs.m_adapter);
+        PendingCrossing rhsPending;
+        {
+            std::lock_guard<std::mutex> lock(rhs.m_mutex);
+            m_adapter = std::move_if_noexcept(rhs.m_adapter);
+            markModifiedLocked();
+            rhs.markModifiedLocked();
+            rhsPending = rhs.takePendingCrossingLocked();
+        }
+        rhs.fireWatermarkCrossing(rhsPending);
     }
 
     template<template<typename...> typename Adapt,
@@ -149,8 +473,14 @@ namespace mt
     {
         if (this != &rhs)
         {
-            std::scoped_lock lock(m_mutex, rhs.m_mutex);
-            m_adapter = rhs.m_adapter;
+            PendingCrossing pending;
+            {
+                std::scoped_lock lock(m_mutex, rhs.m_mutex);
+                m_adapter = rhs.m_adapter;
+                markModifiedLocked();
+                pending = takePendingCrossingLocked();
+            }
+            fireWatermarkCrossing(pending);
         }
         return *this;
     }
@@ -165,8 +495,18 @@ namespace mt
     {
         if (this != &rhs)
         {
-            std::scoped_lock lock(m_mutex, rhs.m_mutex);
-            m_adapter = std::move_if_noexcept(rhs.m_adapter);
+            PendingCrossing pending;
+            PendingCrossing rhsPending;
+            {
+                std::scoped_lock lock(m_mutex, rhs.m_mutex);
+                m_adapter = std::move_if_noexcept(rhs.m_adapter);
+                markModifiedLocked();
+                rhs.markModifiedLocked();
+                pending = takePendingCrossingLocked();
+                rhsPending = rhs.takePendingCrossingLocked();
+            }
+            fireWatermarkCrossing(pending);
+            rhs.fireWatermarkCrossing(rhsPending);
         }
         return *this;
     }
@@ -177,9 +517,34 @@ namespace mt
         typename AllocElem, typename... Ts>
     void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::push(Elem value)
     {
-        std::shared_ptr<Elem> item(std::make_shared<Elem>(std::move_if_noexcept(value)));
-        std::lock_guard<std::mutex> lock(m_mutex);
+        std::shared_ptr<Elem> item(std::allocate_shared<Elem>(m_elemAllocator, std::move_if_noexcept(value)));
+        ModificationLock lock(*this);
+        applyTimeToLiveLocked(*item);
         m_adapter.push(std::move(item));
+        markModifiedLocked();
+    }
+
+    // Pushes all of values under a single lock acquisition and leaves values empty.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::pushBatch(std::vector<Elem>& values)
+    {
+        std::vector<std::shared_ptr<Elem>> items;
+        items.reserve(values.size());
+        for (auto& value : values)
+        {
+            items.push_back(std::allocate_shared<Elem>(m_elemAllocator, std::move_if_noexcept(value)));
+        }
+        values.clear();
+        ModificationLock lock(*this);
+        for (auto& item : items)
+        {
+            applyTimeToLiveLocked(*item);
+            m_adapter.push(std::move(item));
+        }
+        markModifiedLocked();
     }
 
     template<template<typename...> typename Adapt,
@@ -198,10 +563,9 @@ namespace mt
         typename AllocElem, typename... Ts>
     void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::waitAndPop(Elem& value)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_condVar.wait(lock, [&] { return !m_adapter.empty(); });
-        value = std::move_if_noexcept(*getCurrent<Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>>(m_adapter));
-        m_adapter.pop();
+        ModificationLock lock(*this);
+        m_condVar.wait(lock.get(), [&] { return !dropExpiredLocked(); });
+        takeCurrentLocked(value);
     }
 
     template<template<typename...> typename Adapt,
@@ -211,11 +575,9 @@ namespace mt
     std::shared_ptr<typename ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::Elem>
         ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::waitAndPop()
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_condVar.wait(lock, [&] { return !m_adapter.empty(); });
-        std::shared_ptr<Elem> res = std::move(getCurrent<Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>>(m_adapter));
-        m_adapter.pop();
-        return res;
+        ModificationLock lock(*this);
+        m_condVar.wait(lock.get(), [&] { return !dropExpiredLocked(); });
+        return takeCurrentLocked();
     }
 
     template<template<typename...> typename Adapt,
@@ -224,13 +586,12 @@ namespace mt
         typename AllocElem, typename... Ts>
     bool ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::tryPop(Elem& value)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_adapter.empty())
+        ModificationLock lock(*this);
+        if (dropExpiredLocked())
         {
             return false;
         }
-        value = std::move_if_noexcept(*getCurrent<Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>>(m_adapter));
-        m_adapter.pop();
+        takeCurrentLocked(value);
         return true;
     }
 
@@ -241,14 +602,29 @@ namespace mt
     std::shared_ptr<typename ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::Elem>
         ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::tryPop()
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_adapter.empty())
+        ModificationLock lock(*this);
+        if (dropExpiredLocked())
         {
             return std::shared_ptr<Elem>{};
         }
-        std::shared_ptr<Elem> res = std::move(getCurrent<Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>>(m_adapter));
-        m_adapter.pop();
-        return res;
+        return takeCurrentLocked();
+    }
+
+    // Appends up to maxCount elements to values under a single lock acquisition.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    std::size_t ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::tryPopBatch(std::vector<Elem>& values, const std::size_t maxCount)
+    {
+        ModificationLock lock(*this);
+        values.reserve(values.size() + std::min(maxCount, m_adapter.size()));
+        std::size_t count = 0;
+        for (; count < maxCount && !dropExpiredLocked(); ++count)
+        {
+            takeCurrentLocked(values.emplace_back());
+        }
+        return count;
     }
 
     template<template<typename...> typename Adapt,
@@ -257,13 +633,12 @@ namespace mt
         typename AllocElem, typename... Ts>
     void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::pop(Elem& value)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_adapter.empty())
+        ModificationLock lock(*this);
+        if (dropExpiredLocked())
         {
             throw EmptyAdapter{};
         }
-        value = std::move_if_noexcept(*getCurrent<Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>>(m_adapter));
-        m_adapter.pop();
+        takeCurrentLocked(value);
     }
 
     template<template<typename...> typename Adapt,
@@ -273,26 +648,546 @@ namespace mt
     std::shared_ptr<typename ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::Elem>
         ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::pop()
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (m_adapter.empty())
+        ModificationLock lock(*this);
+        if (dropExpiredLocked())
         {
             throw EmptyAdapter{};
         }
+        return takeCurrentLocked();
+    }
+
+    // Only containers with reserve, such as the std::vector under std::priority_queue, are pre-sized.
+    // std::deque, the default under std::queue and std::stack, allocates in fixed-size blocks and
+    // cannot reserve, so for it this is a no-op; a std::stack can be given a std::vector instead.
+    // Elements are allocated with the container's allocator, so to keep both the deque blocks and
+    // the elements off the global heap, back a std::pmr container with a pool resource over a
+    // pre-sized upstream such as HugePageResource.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::reserve(const std::size_t capacity)
+    {
+        if constexpr (detectReserveMethod<Cont<ContElem, Alloc<AllocElem>>>())
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            getProtectedContainer(m_adapter).reserve(capacity);
+        }
+    }
+
+    // Reallocates under the lock, so call it from a maintenance path rather than next to push/pop.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::shrinkToFit()
+    {
+        if constexpr (detectShrinkToFitMethod<Cont<ContElem, Alloc<AllocElem>>>())
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            getProtectedContainer(m_adapter).shrink_to_fit();
+        }
+    }
+
+    // The file is written from a snapshot, without holding the lock, into a temporary that is
+    // synced and then renamed over path, so a crash leaves either the old or the new checkpoint.
+    // Elements are stored in container order,
+    // which for std::priority_queue is heap order, so restoreFrom needs no reordering.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::checkpoint(const std::filesystem::path& path)
+    {
+        static_assert(std::is_trivially_copyable_v<Elem>, "Checkpointing requires trivially copyable elements");
+        const std::shared_ptr<const Snapshot> items = snapshot();
+        CheckpointHeader header{ {}, sizeof(Elem), items->size() };
+        std::memcpy(header.magic, CheckpointHeader::Magic, sizeof(header.magic));
+        constexpr std::size_t BufferSize = std::max<std::size_t>(std::size_t{ 1 } << 16, sizeof(CheckpointHeader) + sizeof(Elem));
+        std::vector<std::byte> buffer(BufferSize);
+
+        std::filesystem::path temporaryPath = path;
+        temporaryPath += ".tmp";
+        const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        if (fd < 0)
+        {
+            throw CheckpointWriteFailed{};
+        }
+        const auto writeAll = [fd](const std::byte* data, std::size_t size) noexcept
+            {
+                while (size > 0)
+                {
+                    const ssize_t count = ::write(fd, data, size);
+                    if (count < 0 && errno != EINTR)
+                    {
+                        return false;
+                    }
+                    if (count > 0)
+                    {
+                        data += count;
+                        size -= static_cast<std::size_t>(count);
+                    }
+                }
+                return true;
+            };
+
+        // Nothing below throws until the descriptor is closed, and the temporary is removed
+        // unless it has been renamed into place.
+        std::memcpy(buffer.data(), &header, sizeof(header));
+        std::size_t used = sizeof(header);
+        bool written = true;
+        for (const auto& item : *items)
+        {
+            if (used + sizeof(Elem) > BufferSize)
+            {
+                written = written && writeAll(buffer.data(), used);
+                used = 0;
+            }
+            std::memcpy(buffer.data() + used, item.get(), sizeof(Elem));
+            used += sizeof(Elem);
+        }
+        written = written && writeAll(buffer.data(), used) && ::fsync(fd) == 0;
+        written = ::close(fd) == 0 && written;
+        if (!written || ::rename(temporaryPath.c_str(), path.c_str()) != 0)
+        {
+            ::unlink(temporaryPath.c_str());
+            throw CheckpointWriteFailed{};
+        }
+
+        // The rename itself is durable only once the directory holding it has been synced.
+        const std::filesystem::path directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+        const int directoryFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (directoryFd < 0)
+        {
+            throw CheckpointNotDurable{};
+        }
+        const bool synced = ::fsync(directoryFd) == 0;
+        ::close(directoryFd);
+        if (!synced)
+        {
+            throw CheckpointNotDurable{};
+        }
+    }
+
+    // Replaces the current contents with the checkpointed elements, which are copied out of the
+    // mapped file into one allocation each, so that no element shares ownership with another.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::restoreFrom(const std::filesystem::path& path)
+    {
+        static_assert(std::is_trivially_copyable_v<Elem>, "Checkpointing requires trivially copyable elements");
+        struct alignas(Elem) Storage
+        {
+            std::byte bytes[sizeof(Elem)];
+        };
+
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            throw CheckpointRestoreFailed{};
+        }
+        struct stat fileStat{};
+        if (::fstat(fd, &fileStat) != 0 || static_cast<std::size_t>(fileStat.st_size) < sizeof(CheckpointHeader))
+        {
+            ::close(fd);
+            throw CheckpointRestoreFailed{};
+        }
+        const auto fileSize = static_cast<std::size_t>(fileStat.st_size);
+        void* const mapping = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            throw CheckpointRestoreFailed{};
+        }
+        ::madvise(mapping, fileSize, MADV_SEQUENTIAL);
+        const auto unmap = [fileSize](void* const p) { ::munmap(p, fileSize); };
+        const std::unique_ptr<void, decltype(unmap)> mappingGuard(mapping, unmap);
+
+        CheckpointHeader header;
+        std::memcpy(&header, mapping, sizeof(header));
+        if (std::memcmp(header.magic, CheckpointHeader::Magic, sizeof(header.magic)) != 0 || header.elemSize != sizeof(Elem)
+            || header.count > (fileSize - sizeof(header)) / sizeof(Elem))
+        {
+            throw CheckpointRestoreFailed{};
+        }
+
+        const auto count = static_cast<std::size_t>(header.count);
+        const std::byte* source = static_cast<const std::byte*>(mapping) + sizeof(header);
+        Cont<ContElem, Alloc<AllocElem>> restored{ Alloc<AllocElem>(m_elemAllocator) };
+        if constexpr (detectReserveMethod<Cont<ContElem, Alloc<AllocElem>>>())
+        {
+            restored.reserve(count);
+        }
+        for (std::size_t i = 0; i < count; ++i, source += sizeof(Elem))
+        {
+            std::shared_ptr<Storage> storage = std::allocate_shared<Storage>(Alloc<Storage>(m_elemAllocator));
+            std::memcpy(storage.get(), source, sizeof(Elem));
+            Elem* const item = std::launder(reinterpret_cast<Elem*>(storage.get()));
+            restored.push_back(std::shared_ptr<Elem>(std::move(storage), item));
+        }
+
+        {
+            ModificationLock lock(*this);
+            getProtectedContainer(m_adapter) = std::move(restored);
+            markModifiedLocked();
+        }
+        m_condVar.notify_all();
+    }
+
+    // The size queries are lock-free and may lag behind concurrent pushes and pops.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    std::size_t ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::sizeApprox() const noexcept
+    {
+        return m_counters.size.load(std::memory_order_relaxed);
+    }
+
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    bool ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::emptyApprox() const noexcept
+    {
+        return sizeApprox() == 0;
+    }
+
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    std::size_t ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::highWaterMark() const noexcept
+    {
+        return m_counters.highWaterMark.load(std::memory_order_relaxed);
+    }
+
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::resetHighWaterMark() noexcept
+    {
+        m_counters.highWaterMark.store(sizeApprox(), std::memory_order_relaxed);
+    }
+
+    // Both are derived from size changes, so expired drops count as dequeued and swaps or restores
+    // count by how much they changed the size.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    std::uint64_t ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::enqueuedCount() const noexcept
+    {
+        return m_counters.enqueued.load(std::memory_order_relaxed);
+    }
+
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    std::uint64_t ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::dequeuedCount() const noexcept
+    {
+        return m_counters.dequeued.load(std::memory_order_relaxed);
+    }
+
+    // Elements of type Expiring pushed without a deadline get now + timeToLive; zero disables it.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::setTimeToLive(const std::chrono::steady_clock::duration timeToLive)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_timeToLive = timeToLive;
+    }
+
+    // Drops the expired elements at the front of the adapter in one pass under the lock.
+    // Dequeues do the same, so this is only needed to release memory of an idle backlog.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    std::size_t ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::purgeExpired()
+    {
+        ModificationLock lock(*this);
+        const std::uint64_t before = m_counters.expired.load(std::memory_order_relaxed);
+        static_cast<void>(dropExpiredLocked());
+        return static_cast<std::size_t>(m_counters.expired.load(std::memory_order_relaxed) - before);
+    }
+
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    std::uint64_t ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::expiredCount() const noexcept
+    {
+        return m_counters.expired.load(std::memory_order_relaxed);
+    }
+
+    // Callbacks are edge-triggered: onHigh fires once the size reaches high, and onLow fires once it
+    // has dropped back to low, which must be below high. They run outside the adapter lock, one at a
+    // time, and a crossing that has already been superseded by a later one is not reported. An
+    // exception thrown by a callback is reported to std::cerr and otherwise ignored.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::setWatermarks(const std::size_t high, const std::size_t low,
+        std::function<void()> onHigh, std::function<void()> onLow)
+    {
+        if (low >= high)
+        {
+            throw InvalidWatermarks{};
+        }
+        auto watermarks = std::make_shared<const Watermarks>(Watermarks{ high, low, std::move(onHigh), std::move(onLow) });
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_watermarks = std::move(watermarks);
+        m_aboveHighWatermark = false;
+    }
+
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    typename ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::PendingCrossing
+        ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::takePendingCrossingLocked() noexcept
+    {
+        return PendingCrossing{ m_watermarks, std::exchange(m_pendingCrossing, WatermarkCrossing::None), m_crossingSequence };
+    }
+
+    // Also runs from ModificationLock's destructor, so nothing may escape.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::fireWatermarkCrossing(const PendingCrossing& pending) noexcept
+    {
+        if (pending.crossing == WatermarkCrossing::None)
+        {
+            return;
+        }
+        try
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_watermarkMutex);
+            if (pending.sequence <= m_firedCrossingSequence)
+            {
+                return;
+            }
+            m_firedCrossingSequence = pending.sequence;
+            const auto& callback = pending.crossing == WatermarkCrossing::High ? pending.watermarks->onHigh : pending.watermarks->onLow;
+            if (callback)
+            {
+                callback();
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << "ThreadSafeSTLAdapter -> Watermark callback failed: " << ex.what() << std::endl;
+        }
+        catch (...)
+        {
+            std::cerr << "ThreadSafeSTLAdapter -> Watermark callback failed: Unknown exception" << std::endl;
+        }
+    }
+
+    // Readers get an immutable view they can iterate without any lock. A snapshot is rebuilt
+    // under the lock when the contents changed since the last one, otherwise the published one is
+    // shared. Rebuilding copies element pointers only, so the lock is held for one pointer copy per
+    // queued element. A pop copies an element instead of moving it out only while a snapshot
+    // still refers to that element, so snapshot contents never change underneath the reader.
+    // That needs deeply copyable elements; for others a pop would move out of a shared element.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    std::shared_ptr<const typename ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::Snapshot>
+        ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::snapshot()
+    {
+        static_assert(isDeeplyCopyable<Elem>(), "Snapshots require copyable elements, which pops copy while a snapshot shares them");
+        if (const std::shared_ptr<const PublishedSnapshot> published = m_publishedSnapshot.load(std::memory_order_acquire).lock();
+            published && published->version == m_counters.version.load(std::memory_order_acquire))
+        {
+            return std::shared_ptr<const Snapshot>(published, &published->items);
+        }
+
+        auto fresh = std::make_shared<PublishedSnapshot>();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const auto& underlyingContainer = getProtectedContainer(m_adapter);
+            fresh->version = m_counters.version.load(std::memory_order_relaxed);
+            fresh->items.reserve(underlyingContainer.size());
+            fresh->items.assign(underlyingContainer.cbegin(), underlyingContainer.cend());
+        }
+        const std::shared_ptr<const PublishedSnapshot> published = std::move(fresh);
+        m_publishedSnapshot.store(published, std::memory_order_release);
+        return std::shared_ptr<const Snapshot>(published, &published->items);
+    }
+
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::swap(ThreadSafeSTLAdapter& rhs)
+    {
+        if (this != &rhs)
+        {
+            PendingCrossing pending;
+            PendingCrossing rhsPending;
+            {
+                std::scoped_lock lock(m_mutex, rhs.m_mutex);
+                std::swap(m_adapter, rhs.m_adapter);
+                markModifiedLocked();
+                rhs.markModifiedLocked();
+                pending = takePendingCrossingLocked();
+                rhsPending = rhs.takePendingCrossingLocked();
+            }
+            fireWatermarkCrossing(pending);
+            rhs.fireWatermarkCrossing(rhsPending);
+        }
+    }
+
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::markModifiedLocked() noexcept
+    {
+        const std::size_t size = m_adapter.size();
+        const std::size_t previous = m_counters.size.load(std::memory_order_relaxed);
+        if (size > previous)
+        {
+            m_counters.enqueued.store(m_counters.enqueued.load(std::memory_order_relaxed) + (size - previous), std::memory_order_relaxed);
+        }
+        else
+        {
+            m_counters.dequeued.store(m_counters.dequeued.load(std::memory_order_relaxed) + (previous - size), std::memory_order_relaxed);
+        }
+        m_counters.size.store(size, std::memory_order_relaxed);
+        if (size > m_counters.highWaterMark.load(std::memory_order_relaxed))
+        {
+            m_counters.highWaterMark.store(size, std::memory_order_relaxed);
+        }
+        m_counters.version.store(m_counters.version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        if (m_watermarks)
+        {
+            if (!m_aboveHighWatermark && size >= m_watermarks->high)
+            {
+                m_aboveHighWatermark = true;
+                m_pendingCrossing = WatermarkCrossing::High;
+                ++m_crossingSequence;
+            }
+            else if (m_aboveHighWatermark && size <= m_watermarks->low)
+            {
+                m_aboveHighWatermark = false;
+                m_pendingCrossing = WatermarkCrossing::Low;
+                ++m_crossingSequence;
+            }
+        }
+    }
+
+    // Only snapshots take further references to queued elements, and only under the lock, so an
+    // element held by the container alone stays unshared. The fence pairs with the release of the
+    // last snapshot reference, so its reads finish before the element is moved out.
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    bool ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::isSharedLocked(const std::shared_ptr<Elem>& item) noexcept
+    {
+        if (item.use_count() != 1)
+        {
+            return true;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return false;
+    }
+
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::takeCurrentLocked(Elem& value)
+    {
+        auto& current = getCurrent<Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>>(m_adapter);
+        if constexpr (isDeeplyCopyable<Elem>())
+        {
+            if (isSharedLocked(current))
+            {
+                value = std::as_const(*current);
+                m_adapter.pop();
+                markModifiedLocked();
+                return;
+            }
+        }
+        value = std::move_if_noexcept(*current);
+        m_adapter.pop();
+        markModifiedLocked();
+    }
+
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    std::shared_ptr<typename ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::Elem>
+        ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::takeCurrentLocked()
+    {
         std::shared_ptr<Elem> res = std::move(getCurrent<Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>>(m_adapter));
         m_adapter.pop();
+        markModifiedLocked();
+        if constexpr (isDeeplyCopyable<Elem>())
+        {
+            if (isSharedLocked(res))
+            {
+                res = std::allocate_shared<Elem>(m_elemAllocator, std::as_const(*res));
+            }
+        }
         return res;
     }
 
+    // Pops the expired elements at the front and returns whether the adapter is empty afterwards.
     template<template<typename...> typename Adapt,
         typename AdaptElem, template<typename...> typename Cont,
         typename ContElem, template<typename> typename Alloc,
         typename AllocElem, typename... Ts>
-    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::swap(ThreadSafeSTLAdapter& rhs)
+    bool ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::dropExpiredLocked()
     {
-        if (this != &rhs)
+        if constexpr (IsExpiring<Elem>::value)
+        {
+            if (m_adapter.empty())
+            {
+                return true;
+            }
+            const auto now = Elem::Clock::now();
+            std::uint64_t dropped = 0;
+            while (!m_adapter.empty() && getCurrent<Adapt<AdaptElem, Cont<ContElem, Alloc<AllocElem>>, Ts...>>(m_adapter)->deadline <= now)
+            {
+                m_adapter.pop();
+                ++dropped;
+            }
+            if (dropped != 0)
+            {
+                m_counters.expired.store(m_counters.expired.load(std::memory_order_relaxed) + dropped, std::memory_order_relaxed);
+                markModifiedLocked();
+            }
+        }
+        return m_adapter.empty();
+    }
+
+    template<template<typename...> typename Adapt,
+        typename AdaptElem, template<typename...> typename Cont,
+        typename ContElem, template<typename> typename Alloc,
+        typename AllocElem, typename... Ts>
+    void ThreadSafeSTLAdapter<Adapt, AdaptElem, Cont, ContElem, Alloc, AllocElem, Ts...>::applyTimeToLiveLocked(Elem& value) const
+    {
+        if constexpr (IsExpiring<Elem>::value)
         {
-            std::scoped_lock lock(m_mutex, rhs.m_mutex);
-            std::swap(m_adapter, rhs.m_adapter);
+            if (m_timeToLive != std::chrono::steady_clock::duration::zero() && value.deadline == Elem::Clock::time_point::max())
+            {
+                value.deadline = Elem::Clock::now() + m_timeToLive;
+            }
         }
     }
 
@@ -354,20 +1249,29 @@ namespace mt
         {
             // std::priority_queue
             Adapt<std::shared_ptr<AdaptElem>, Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>>, CustomComparator<Ts...>>
-                adapterWithSharedPtrElements{ CustomComparator{std::move(comparator...)} };
+                adapterWithSharedPtrElements(CustomComparator{ std::move(comparator...) },
+                    Alloc<std::shared_ptr<AllocElem>>(underlyingContainer.get_allocator()));
             auto& underlyingSharedPtrContainer = getProtectedContainer(adapterWithSharedPtrElements);
+            if constexpr (detectReserveMethod<Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>>>())
+            {
+                underlyingSharedPtrContainer.reserve(underlyingContainer.size());
+            }
             std::transform(underlyingContainer.cbegin(), underlyingContainer.cend(), std::back_inserter(underlyingSharedPtrContainer),
-                [](auto& item) { return std::make_shared<AdaptElem>(item); });
+                [allocator = Alloc<AdaptElem>(underlyingContainer.get_allocator())](auto& item) { return std::allocate_shared<AdaptElem>(allocator, item); });
             return ThreadSafeSTLAdapter{ std::move(adapterWithSharedPtrElements) };
         }
         if constexpr (sizeof...(Ts) == 0)
         {
             // std::stack / std::queue
             Adapt<std::shared_ptr<AdaptElem>, Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>>>
-                adapterWithSharedPtrElements{ };
+                adapterWithSharedPtrElements(Alloc<std::shared_ptr<AllocElem>>(underlyingContainer.get_allocator()));
             auto& underlyingSharedPtrContainer = getProtectedContainer(adapterWithSharedPtrElements);
+            if constexpr (detectReserveMethod<Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>>>())
+            {
+                underlyingSharedPtrContainer.reserve(underlyingContainer.size());
+            }
             std::transform(underlyingContainer.cbegin(), underlyingContainer.cend(), std::back_inserter(underlyingSharedPtrContainer),
-                [](auto& item) { return std::make_shared<AdaptElem>(item); });
+                [allocator = Alloc<AdaptElem>(underlyingContainer.get_allocator())](auto& item) { return std::allocate_shared<AdaptElem>(allocator, item); });
             return ThreadSafeSTLAdapter{ std::move(adapterWithSharedPtrElements) };
         }
     }
@@ -383,20 +1287,29 @@ namespace mt
         {
             // std::priority_queue
             Adapt<std::shared_ptr<AdaptElem>, Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>>, CustomComparator<Ts...>>
-                adapterWithSharedPtrElements{ CustomComparator{std::move(comparator...)} };
+                adapterWithSharedPtrElements(CustomComparator{ std::move(comparator...) },
+                    Alloc<std::shared_ptr<AllocElem>>(underlyingContainer.get_allocator()));
             auto& underlyingSharedPtrContainer = getProtectedContainer(adapterWithSharedPtrElements);
+            if constexpr (detectReserveMethod<Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>>>())
+            {
+                underlyingSharedPtrContainer.reserve(underlyingContainer.size());
+            }
             std::transform(underlyingContainer.begin(), underlyingContainer.end(), std::back_inserter(underlyingSharedPtrContainer),
-                [](auto& item) { return std::make_shared<AdaptElem>(std::move(item)); });
+                [allocator = Alloc<AdaptElem>(underlyingContainer.get_allocator())](auto& item) { return std::allocate_shared<AdaptElem>(allocator, std::move(item)); });
             return ThreadSafeSTLAdapter{ std::move(adapterWithSharedPtrElements) };
         }
         if constexpr (sizeof...(Ts) == 0)
         {
             // std::stack / std::queue
             Adapt<std::shared_ptr<AdaptElem>, Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>>>
-                adapterWithSharedPtrElements{ };
+                adapterWithSharedPtrElements(Alloc<std::shared_ptr<AllocElem>>(underlyingContainer.get_allocator()));
             auto& underlyingSharedPtrContainer = getProtectedContainer(adapterWithSharedPtrElements);
+            if constexpr (detectReserveMethod<Cont<std::shared_ptr<ContElem>, Alloc<std::shared_ptr<AllocElem>>>>())
+            {
+                underlyingSharedPtrContainer.reserve(underlyingContainer.size());
+            }
             std::transform(underlyingContainer.begin(), underlyingContainer.end(), std::back_inserter(underlyingSharedPtrContainer),
-                [](auto& item) { return std::make_shared<AdaptElem>(std::move(item)); });
+                [allocator = Alloc<AdaptElem>(underlyingContainer.get_allocator())](auto& item) { return std::allocate_shared<AdaptElem>(allocator, std::move(item)); });
             return ThreadSafeSTLAdapter{ std::move(adapterWithSharedPtrElements) };
         }
     }
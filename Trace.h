@@ -0,0 +1,305 @@
+/**
+ * @file Trace.h
+ *
+ * @brief Tracer class for recording pipeline activity and exporting it as a Chrome trace.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mt
+{
+    struct TraceWriteFailed : std::exception
+    {
+        [[nodiscard]] const char* what() const noexcept override { return "Exception: Failed to write the trace"; }
+    };
+
+    struct TraceEvent
+    {
+        const char* name;
+        std::int64_t timestampNs;
+        char phase;
+    };
+
+    // Written only by its owning thread and read by writeChromeTrace up to the published count.
+    // Events past Capacity are dropped rather than overwriting ones a reader may be copying.
+    // Tracer::clear only raises clearRequested; the owning thread empties the buffer on its next
+    // event, and until then readers treat the buffer as empty. Once its thread has exited, a
+    // buffer is released by the next export that wrote its events or the next clear.
+    struct TraceBuffer
+    {
+        static constexpr std::size_t Capacity = std::size_t{ 1 } << 16;
+
+        std::unique_ptr<TraceEvent[]> events{ std::make_unique<TraceEvent[]>(Capacity) };
+        std::atomic<std::size_t> count{ 0 };
+        std::atomic<std::uint64_t> dropped{ 0 };
+        std::atomic<bool> clearRequested{ false };
+        std::atomic<bool> exited{ false };
+        std::uint32_t threadId = 0;
+        std::string threadName;
+    };
+
+    // Process-wide tracing switch. While disabled, begin/end cost one relaxed load; while enabled
+    // every thread appends to its own buffer without locks, allocated on its first event.
+    class Tracer
+    {
+    private:
+        struct Registry
+        {
+            std::mutex mutex;
+            std::mutex exportMutex;
+            std::vector<std::shared_ptr<TraceBuffer>> buffers;
+            std::uint32_t nextThreadId = 1;
+        };
+
+        struct LocalState
+        {
+            std::shared_ptr<TraceBuffer> buffer;
+            std::string threadName;
+
+            ~LocalState()
+            {
+                if (buffer)
+                {
+                    buffer->exited.store(true, std::memory_order_release);
+                }
+            }
+        };
+
+        inline static std::atomic<bool> s_enabled{ false };
+
+    public:
+        static void setEnabled(bool enabled) noexcept { s_enabled.store(enabled, std::memory_order_relaxed); }
+        [[nodiscard]] static bool enabled() noexcept { return s_enabled.load(std::memory_order_relaxed); }
+
+        static void setThreadName(std::string_view name);
+        static void begin(const char* name) noexcept { record(name, 'B', now()); }
+        static void end(const char* name) noexcept { record(name, 'E', now()); }
+
+        // For events decided on only after they happened, with timestamps taken earlier by now().
+        static void beginAt(const char* name, std::int64_t timestampNs) noexcept { record(name, 'B', timestampNs); }
+        static void endAt(const char* name, std::int64_t timestampNs) noexcept { record(name, 'E', timestampNs); }
+        [[nodiscard]] static std::int64_t now() noexcept;
+
+        // Discards every event recorded so far, so that a long run can capture the window that follows.
+        static void clear();
+
+        // Writes every recorded event in the Chrome trace event format, viewable in Perfetto or chrome://tracing.
+        static void writeChromeTrace(const std::filesystem::path& path);
+
+    private:
+        [[nodiscard]] static Registry& registry();
+        [[nodiscard]] static LocalState& localState();
+        [[nodiscard]] static TraceBuffer* localBuffer() noexcept;
+        static void record(const char* name, char phase, std::int64_t timestampNs) noexcept;
+    };
+
+    // Records a begin event on construction and the matching end event on destruction.
+    // name must outlive the trace, which string literals do.
+    class TraceScope
+    {
+    private:
+        const char* m_name;
+        bool m_active;
+
+    public:
+        explicit TraceScope(const char* const name) noexcept
+            : m_name(name)
+            , m_active(Tracer::enabled())
+        {
+            if (m_active)
+            {
+                Tracer::begin(m_name);
+            }
+        }
+        TraceScope(const TraceScope&) = delete;
+        TraceScope(TraceScope&&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+        TraceScope& operator=(TraceScope&&) = delete;
+        ~TraceScope()
+        {
+            if (m_active)
+            {
+                Tracer::end(m_name);
+            }
+        }
+    };
+
+    inline Tracer::Registry& Tracer::registry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    inline Tracer::LocalState& Tracer::localState()
+    {
+        thread_local LocalState state;
+        return state;
+    }
+
+    inline void Tracer::setThreadName(const std::string_view name)
+    {
+        LocalState& state = localState();
+        state.threadName = name;
+        if (state.buffer)
+        {
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            state.buffer->threadName = state.threadName;
+        }
+    }
+
+    inline TraceBuffer* Tracer::localBuffer() noexcept
+    {
+        LocalState& state = localState();
+        if (!state.buffer)
+        {
+            try
+            {
+                auto buffer = std::make_shared<TraceBuffer>();
+                Registry& shared = registry();
+                std::lock_guard<std::mutex> lock(shared.mutex);
+                buffer->threadId = shared.nextThreadId++;
+                buffer->threadName = state.threadName;
+                shared.buffers.push_back(buffer);
+                state.buffer = std::move(buffer);
+            }
+            catch (...)
+            {
+                return nullptr;
+            }
+        }
+        return state.buffer.get();
+    }
+
+    inline std::int64_t Tracer::now() noexcept
+    {
+        return static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    inline void Tracer::clear()
+    {
+        Registry& shared = registry();
+        std::scoped_lock lock(shared.exportMutex, shared.mutex);
+        std::erase_if(shared.buffers, [](const std::shared_ptr<TraceBuffer>& buffer)
+            {
+                return buffer->exited.load(std::memory_order_acquire);
+            });
+        for (const auto& buffer : shared.buffers)
+        {
+            buffer->clearRequested.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    inline void Tracer::record(const char* const name, const char phase, const std::int64_t timestampNs) noexcept
+    {
+        TraceBuffer* const buffer = localBuffer();
+        if (!buffer)
+        {
+            return;
+        }
+        if (buffer->clearRequested.load(std::memory_order_relaxed))
+        {
+            buffer->count.store(0, std::memory_order_relaxed);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+            buffer->clearRequested.store(false, std::memory_order_release);
+        }
+        const std::size_t index = buffer->count.load(std::memory_order_relaxed);
+        if (index == TraceBuffer::Capacity)
+        {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer->events[index] = TraceEvent{ name, timestampNs, phase };
+        buffer->count.store(index + 1, std::memory_order_release);
+    }
+
+    inline void Tracer::writeChromeTrace(const std::filesystem::path& path)
+    {
+        std::vector<std::shared_ptr<TraceBuffer>> buffers;
+        std::vector<std::string> threadNames;
+        std::vector<std::shared_ptr<TraceBuffer>> exited;
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> exportLock(shared.exportMutex);
+        {
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            buffers = shared.buffers;
+            for (const auto& buffer : buffers)
+            {
+                threadNames.push_back(buffer->threadName);
+                // Checked before the events are read, so that every event of these buffers is written.
+                if (buffer->exited.load(std::memory_order_acquire))
+                {
+                    exited.push_back(buffer);
+                }
+            }
+        }
+
+        std::ofstream out(path, std::ios::trunc);
+        out << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        const auto separator = [&]() -> std::ostream&
+            {
+                out << (first ? "\n" : ",\n");
+                first = false;
+                return out;
+            };
+        for (std::size_t i = 0; i < buffers.size(); ++i)
+        {
+            const TraceBuffer& buffer = *buffers[i];
+            const std::string& name = threadNames[i].empty() ? "thread" : threadNames[i];
+            separator() << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer.threadId
+                << R"(,"args":{"name":")" << name << " " << buffer.threadId << "\"}}";
+            // A buffer still waiting for its owner to apply a clear holds only discarded events.
+            if (buffer.clearRequested.load(std::memory_order_acquire))
+            {
+                continue;
+            }
+            const std::size_t count = buffer.count.load(std::memory_order_acquire);
+            for (std::size_t j = 0; j < count; ++j)
+            {
+                const TraceEvent& event = buffer.events[j];
+                separator() << R"({"name":")" << event.name << R"(","ph":")" << event.phase
+                    << R"(","ts":)" << static_cast<double>(event.timestampNs) / 1000.0 << R"(,"pid":1,"tid":)" << buffer.threadId << '}';
+            }
+            if (const std::uint64_t dropped = buffer.dropped.load(std::memory_order_relaxed); dropped != 0)
+            {
+                separator() << R"({"name":"dropped events","ph":"C","ts":0,"pid":1,"tid":)" << buffer.threadId
+                    << R"(,"args":{"dropped":)" << dropped << "}}";
+            }
+        }
+        out << "\n]}\n";
+        if (!out.flush())
+        {
+            throw TraceWriteFailed{};
+        }
+
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        std::erase_if(shared.buffers, [&](const std::shared_ptr<TraceBuffer>& buffer)
+            {
+                return std::find(exited.begin(), exited.end(), buffer) != exited.end();
+            });
+    }
+} // namespace mt
+
+#endif
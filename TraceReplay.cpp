@@ -0,0 +1,204 @@
+/**
+ * @file TraceReplay.cpp
+ *
+ * @brief Replays a recorded push trace against an adapter and consumer configuration.
+ *
+ * @author Hovsep Papoyan
+ * Contact: papoyanhovsep93@gmail.com
+ * @Date 2026-10-18
+ *
+ */
+
+#include "Consumer.h"
+#include "Producer.h"
+#include "PushTrace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <stack>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // The push time travels with the payload so that consumers can measure end-to-end latency.
+    using ReplayItem = std::pair<std::int64_t, std::string>;
+
+    struct ReplayOptions
+    {
+        std::string tracePath;
+        std::string adapter = "queue";
+        std::size_t consumers = 1;
+        double rate = 1.0;
+    };
+
+    [[nodiscard]] std::int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    struct LatencySink
+    {
+        std::vector<std::int64_t>* latencies;
+        std::atomic<std::uint64_t>* received;
+
+        void operator()(const ReplayItem& item) const
+        {
+            latencies->push_back(nowNs() - item.first);
+            received->fetch_add(1, std::memory_order_release);
+        }
+    };
+
+    [[nodiscard]] double percentileUs(const std::vector<std::int64_t>& sorted, const double fraction)
+    {
+        if (sorted.empty())
+        {
+            return 0.0;
+        }
+        const auto index = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1));
+        return static_cast<double>(sorted[index]) / 1000.0;
+    }
+
+    // Pushes every record at its recorded offset divided by rate, with one element per recorded
+    // element whose payload spreads the recorded bytes evenly.
+    template<typename Adapter>
+    void replay(Adapter& sharedContainer, const std::vector<mt::PushRecord>& records, const ReplayOptions& options)
+    {
+        std::atomic<std::uint64_t> received{ 0 };
+        std::vector<std::vector<std::int64_t>> latencies(options.consumers);
+        mt::Producer<Adapter> producer(sharedContainer);
+        std::vector<std::unique_ptr<mt::Consumer<Adapter, LatencySink>>> consumers;
+        for (std::size_t i = 0; i < options.consumers; ++i)
+        {
+            consumers.push_back(std::make_unique<mt::Consumer<Adapter, LatencySink>>(sharedContainer, LatencySink{ &latencies[i], &received }));
+        }
+        producer.enableWorkerThread();
+        for (auto& consumer : consumers)
+        {
+            consumer->enableWorkerThread();
+        }
+
+        std::uint64_t elements = 0;
+        std::uint64_t bytes = 0;
+        std::int64_t maxLagNs = 0;
+        const auto start = Clock::now();
+        for (const mt::PushRecord& record : records)
+        {
+            const auto target = start + std::chrono::nanoseconds(static_cast<std::int64_t>(static_cast<double>(record.offsetNs) / options.rate));
+            std::this_thread::sleep_until(target);
+            maxLagNs = std::max<std::int64_t>(maxLagNs, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - target).count());
+
+            const std::size_t size = record.items == 0 ? 0 : static_cast<std::size_t>(record.bytes / record.items);
+            const std::int64_t pushedNs = nowNs();
+            std::vector<ReplayItem> items;
+            items.reserve(static_cast<std::size_t>(record.items));
+            for (std::uint64_t i = 0; i < record.items; ++i)
+            {
+                items.emplace_back(pushedNs, std::string(size, 'x'));
+            }
+            producer.push(std::move(items));
+            elements += record.items;
+            bytes += record.bytes;
+        }
+        while (received.load(std::memory_order_acquire) < elements)
+        {
+            std::this_thread::yield();
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        consumers.clear();
+
+        std::vector<std::int64_t> merged;
+        for (const auto& part : latencies)
+        {
+            merged.insert(merged.end(), part.cbegin(), part.cend());
+        }
+        std::sort(merged.begin(), merged.end());
+        std::cout << "replay adapter=" << options.adapter << " consumers=" << options.consumers << " rate=" << options.rate
+            << " pushes=" << records.size() << " elements=" << elements << " bytes=" << bytes
+            << std::fixed << std::setprecision(3) << " seconds=" << seconds
+            << std::setprecision(1) << " max-lag=" << static_cast<double>(maxLagNs) / 1000.0 << "us"
+            << " latency-p50=" << percentileUs(merged, 0.5) << "us"
+            << " latency-p99=" << percentileUs(merged, 0.99) << "us"
+            << " latency-max=" << percentileUs(merged, 1.0) << "us" << std::endl;
+    }
+} // namespace
+
+// Usage: TraceReplay <trace> [--adapter queue|stack|priority_queue] [--consumers <n>] [--rate <speedup>]
+// A trace is written by a PushTraceRecorder attached with Producer::setPushTrace. --rate 2 replays
+// it twice as fast as it was recorded.
+int main(int argc, char* argv[])
+{
+    ReplayOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--adapter" && i + 1 < argc)
+        {
+            options.adapter = argv[++i];
+        }
+        else if (arg == "--consumers" && i + 1 < argc)
+        {
+            options.consumers = std::max<std::size_t>(std::strtoul(argv[++i], nullptr, 10), 1);
+        }
+        else if (arg == "--rate" && i + 1 < argc)
+        {
+            options.rate = std::strtod(argv[++i], nullptr);
+        }
+        else
+        {
+            options.tracePath = arg;
+        }
+    }
+    if (options.tracePath.empty() || !(options.rate > 0.0))
+    {
+        std::cerr << "Usage: " << argv[0] << " <trace> [--adapter queue|stack|priority_queue] [--consumers <n>] [--rate <speedup>]" << std::endl;
+        return 2;
+    }
+
+    try
+    {
+        const std::vector<mt::PushRecord> records = mt::PushTraceRecorder::read(options.tracePath);
+        if (options.adapter == "queue")
+        {
+            auto sharedContainer = mt::createThreadSafeSTLAdapterFrom(std::queue<ReplayItem>{});
+            replay(sharedContainer, records, options);
+        }
+        else if (options.adapter == "stack")
+        {
+            auto sharedContainer = mt::createThreadSafeSTLAdapterFrom(std::stack<ReplayItem>{});
+            replay(sharedContainer, records, options);
+        }
+        else if (options.adapter == "priority_queue")
+        {
+            auto sharedContainer = mt::createThreadSafeSTLAdapterFrom(std::priority_queue<ReplayItem, std::vector<ReplayItem>, std::less<>>{},
+                std::less<>{});
+            replay(sharedContainer, records, options);
+        }
+        else
+        {
+            std::cerr << "Unknown adapter " << options.adapter << std::endl;
+            return 2;
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "TraceReplay -> " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}